@@ -0,0 +1,51 @@
+#include <benchmark/benchmark.h>
+
+#include "common.hpp"
+#include "coro/arena.hpp"
+#include "coro/http.hpp"
+
+namespace coro {
+
+static const char kRequest[] =
+    "GET /index.html HTTP/1.1\r\n"
+    "Host: example.com\r\n"
+    "User-Agent: coro-bench\r\n"
+    "Accept: text/html\r\n"
+    "Connection: keep-alive\r\n"
+    "\r\n";
+
+static void requestLifecycle(benchmark::State& state, bool arena) {
+  if (arena) {
+    enableArena();
+  }
+  Stream stream = std::make_shared<bench::LoopStream>(kRequest);
+  http::protocol::Response resp;
+  resp.version = "HTTP/1.1";
+  resp.code = 200;
+  resp.reason = "OK";
+  resp.headers = {{"Content-Type", "text/html"}, {"Content-Length", "0"}};
+
+  {
+    bench::AllocCounter counter(state);
+    for (auto _ : state) {
+      auto req = http::protocol::readReq(stream).await();
+      benchmark::DoNotOptimize(req);
+      http::protocol::writeResp(stream, resp).await();
+    }
+  }
+  sched::currentPtr()->setArena(nullptr);
+}
+
+static void BM_HttpRequestHeap(benchmark::State& state) {
+  requestLifecycle(state, false);
+}
+BENCHMARK(BM_HttpRequestHeap);
+
+static void BM_HttpRequestArena(benchmark::State& state) {
+  requestLifecycle(state, true);
+}
+BENCHMARK(BM_HttpRequestArena);
+
+}  // namespace coro
+
+BENCHMARK_MAIN();
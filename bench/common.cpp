@@ -0,0 +1,47 @@
+#include "common.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+// 统计 operator new 的调用次数。operator new[] 和带大小的 operator delete
+// 的默认实现会调用这两个函数，所以无需替换。
+static std::atomic<size_t> alloc_count(0);
+
+void* operator new(size_t size) {
+  alloc_count.fetch_add(1, std::memory_order_relaxed);
+  void* ptr = malloc(size);
+  if (!ptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept { free(ptr); }
+
+namespace coro {
+namespace bench {
+
+size_t allocCount() { return alloc_count.load(std::memory_order_relaxed); }
+
+Promise<size_t> LoopStream::readSome(char* buf, size_t len) {
+  Promise<size_t> promise;
+  size_t n = data_.size() - offset_;
+  if (n > len) {
+    n = len;
+  }
+  memcpy(buf, data_.data() + offset_, n);
+  offset_ = (offset_ + n) % data_.size();
+  promise.resolve(n);
+  return promise;
+}
+
+Promise<size_t> LoopStream::write(const char* buf, size_t len) {
+  Promise<size_t> promise;
+  promise.resolve(len);
+  return promise;
+}
+
+}  // namespace bench
+}  // namespace coro
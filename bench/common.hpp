@@ -0,0 +1,67 @@
+#ifndef CORO_BENCH_COMMON_HPP_
+#define CORO_BENCH_COMMON_HPP_
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <string>
+
+#include "coro/promise.hpp"
+#include "coro/stream.hpp"
+
+namespace coro {
+namespace bench {
+
+/**
+ * @brief 获取进程启动至今 operator new 被调用的次数。
+ * common.cpp 替换了全局的 operator new，所有基准测试程序共享同一个计数器。
+ * @return size_t 分配次数。
+ */
+size_t allocCount();
+
+/**
+ * @brief 统计一段基准测试循环中的内存分配次数，
+ * 并以 allocs/op 的形式报告每次迭代的平均分配次数。
+ */
+class AllocCounter {
+ public:
+  explicit AllocCounter(benchmark::State& state)
+      : state_(state), begin_(allocCount()) {}
+
+  ~AllocCounter() {
+    state_.counters["allocs/op"] = benchmark::Counter(
+        static_cast<double>(allocCount() - begin_),
+        benchmark::Counter::kAvgIterations);
+  }
+
+  // 禁止拷贝和移动。
+  AllocCounter(const AllocCounter&) = delete;
+  AllocCounter& operator=(const AllocCounter&) = delete;
+
+ private:
+  benchmark::State& state_;
+  size_t begin_;
+};
+
+/**
+ * @brief 循环读取同一段数据、丢弃所有写入的内存流，读写都会立即完成。
+ */
+class LoopStream : public impl::Stream {
+ public:
+  explicit LoopStream(std::string data) : data_(std::move(data)) {}
+
+  Promise<size_t> write(const char* buf, size_t len) override;
+  void close() override {}
+
+ protected:
+  Promise<size_t> readSome(char* buf, size_t len) override;
+
+ private:
+  std::string data_;   // 循环读取的数据。
+  size_t offset_ = 0;  // 下一次读取的位置。
+};
+
+}  // namespace bench
+}  // namespace coro
+
+#endif  // CORO_BENCH_COMMON_HPP_
@@ -0,0 +1,113 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include "common.hpp"
+#include "coro/http.hpp"
+#include "coro/http/protocol/parse.hpp"
+#include "coro/pipe.hpp"
+#include "coro/spawn.hpp"
+
+namespace coro {
+
+static const char kRequest[] =
+    "GET /index.html HTTP/1.1\r\n"
+    "Host: example.com\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9\r\n"
+    "Connection: keep-alive\r\n"
+    "\r\n";
+
+static void BM_ParseReqStartLine(benchmark::State& state) {
+  const char line[] = "GET /index.html HTTP/1.1\r\n";
+  std::string method, url, version;
+  bench::AllocCounter counter(state);
+  for (auto _ : state) {
+    bool ok = http::protocol::parseReqStartLine(line, sizeof(line) - 1,
+                                                  method, url, version);
+    benchmark::DoNotOptimize(ok);
+  }
+}
+BENCHMARK(BM_ParseReqStartLine);
+
+static void BM_ParseHeader(benchmark::State& state) {
+  const char line[] =
+      "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36\r\n";
+  std::string name, value;
+  bench::AllocCounter counter(state);
+  for (auto _ : state) {
+    bool ok = http::protocol::parseHeader(line, sizeof(line) - 1, name,
+                                           value);
+    benchmark::DoNotOptimize(ok);
+  }
+}
+BENCHMARK(BM_ParseHeader);
+
+// 从内存流中读取并解析完整的请求头。
+static void BM_ReadReq(benchmark::State& state) {
+  Stream stream = std::make_shared<bench::LoopStream>(kRequest);
+  {
+    bench::AllocCounter counter(state);
+    for (auto _ : state) {
+      auto req = http::protocol::readReq(stream).await();
+      benchmark::DoNotOptimize(req);
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * (sizeof(kRequest) - 1));
+}
+BENCHMARK(BM_ReadReq);
+
+// 序列化并写入响应头。
+static void BM_WriteResp(benchmark::State& state) {
+  Stream stream = std::make_shared<bench::LoopStream>(kRequest);
+  http::protocol::Response resp;
+  resp.version = "HTTP/1.1";
+  resp.code = 200;
+  resp.reason = "OK";
+  resp.headers = {{"Content-Type", "text/html"}, {"Content-Length", "0"}};
+  bench::AllocCounter counter(state);
+  for (auto _ : state) {
+    http::protocol::writeResp(stream, resp).await();
+  }
+}
+BENCHMARK(BM_WriteResp);
+
+// 客户端和服务端协程通过内存管道完成一次完整的 HTTP 请求，不经过内核。
+static void BM_HttpPipeRoundTrip(benchmark::State& state) {
+  auto ends = pipe();
+  Stream client = ends.first;
+  Stream server = ends.second;
+  auto handler = spawn([server]() {
+    http::protocol::Response resp;
+    resp.version = "HTTP/1.1";
+    resp.code = 200;
+    resp.reason = "OK";
+    resp.headers = {{"Content-Type", "text/html"}, {"Content-Length", "0"}};
+    for (;;) {
+      auto req = http::protocol::readReq(server).await();
+      http::protocol::writeResp(server, resp).await();
+    }
+  });
+
+  http::protocol::Request req;
+  req.method = "GET";
+  req.url = "/index.html";
+  req.version = "HTTP/1.1";
+  req.headers = {{"Host", "example.com"}, {"Accept", "text/html"}};
+  {
+    bench::AllocCounter counter(state);
+    for (auto _ : state) {
+      http::protocol::writeReq(client, req).await();
+      auto resp = http::protocol::readResp(client).await();
+      benchmark::DoNotOptimize(resp);
+    }
+  }
+  client->close();
+  std::error_code error;
+  handler.await(&error);
+}
+BENCHMARK(BM_HttpPipeRoundTrip);
+
+}  // namespace coro
+
+BENCHMARK_MAIN();
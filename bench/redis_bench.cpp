@@ -0,0 +1,88 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include "common.hpp"
+#include "coro/pipe.hpp"
+#include "coro/redis.hpp"
+#include "coro/spawn.hpp"
+
+namespace coro {
+
+using redis::protocol::ArrayField;
+using redis::protocol::BulkStringField;
+using redis::protocol::Field;
+
+// 一条 SET 命令和一条 MGET 的回复。
+static const char kArrays[] =
+    "*3\r\n$3\r\nSET\r\n$8\r\nuser:123\r\n$16\r\n0123456789abcdef\r\n"
+    "*4\r\n$5\r\nalice\r\n$-1\r\n$3\r\nbob\r\n$5\r\ncarol\r\n";
+static constexpr size_t kArrayCount = 2;
+
+static void BM_ReadFieldArray(benchmark::State& state) {
+  Stream stream = std::make_shared<bench::LoopStream>(kArrays);
+  {
+    bench::AllocCounter counter(state);
+    for (auto _ : state) {
+      auto field = redis::protocol::readField(stream).await();
+      benchmark::DoNotOptimize(field);
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * (sizeof(kArrays) - 1) /
+                          kArrayCount);
+}
+BENCHMARK(BM_ReadFieldArray);
+
+static void BM_FieldAppend(benchmark::State& state) {
+  auto array = ArrayField::null();
+  array->mut_fields().push_back(BulkStringField::from("SET"));
+  array->mut_fields().push_back(BulkStringField::from("user:123"));
+  array->mut_fields().push_back(BulkStringField::from("0123456789abcdef"));
+  std::string buf;
+  buf.reserve(array->bytes());
+  {
+    bench::AllocCounter counter(state);
+    for (auto _ : state) {
+      buf.clear();
+      array->append(buf);
+      benchmark::DoNotOptimize(buf.data());
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * buf.size());
+}
+BENCHMARK(BM_FieldAppend);
+
+// 客户端和服务端协程通过内存管道完成一次 SET 命令的往返，不经过内核。
+static void BM_RedisPipeRoundTrip(benchmark::State& state) {
+  auto ends = pipe();
+  Stream client = ends.first;
+  Stream server = ends.second;
+  auto handler = spawn([server]() {
+    auto ok = redis::protocol::SimpleStringField::from("OK");
+    for (;;) {
+      redis::protocol::readField(server).await();
+      redis::protocol::writeField(server, ok).await();
+    }
+  });
+
+  auto array = ArrayField::null();
+  array->mut_fields().push_back(BulkStringField::from("SET"));
+  array->mut_fields().push_back(BulkStringField::from("user:123"));
+  array->mut_fields().push_back(BulkStringField::from("0123456789abcdef"));
+  {
+    bench::AllocCounter counter(state);
+    for (auto _ : state) {
+      redis::protocol::writeField(client, array).await();
+      auto resp = redis::protocol::readField(client).await();
+      benchmark::DoNotOptimize(resp);
+    }
+  }
+  client->close();
+  std::error_code error;
+  handler.await(&error);
+}
+BENCHMARK(BM_RedisPipeRoundTrip);
+
+}  // namespace coro
+
+BENCHMARK_MAIN();
@@ -0,0 +1,64 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include "common.hpp"
+#include "coro/scan.hpp"
+
+namespace coro {
+
+// 4 KiB 的数据，要查找的字节位于末尾。
+static const std::string kBlock = std::string(4095, 'a') + "\r\n";
+
+// state.range(0) 为 scan::Isa 的值，CPU 不支持时跳过。
+static bool selectIsa(benchmark::State& state) {
+  auto isa = static_cast<scan::Isa>(state.range(0));
+  if (!scan::setIsa(isa)) {
+    state.SkipWithError("unsupported isa");
+    return false;
+  }
+  state.SetLabel(scan::isaName(isa));
+  return true;
+}
+
+static void BM_FindByte(benchmark::State& state) {
+  if (!selectIsa(state)) {
+    return;
+  }
+  const char* end = kBlock.data() + kBlock.size();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(scan::findByte(kBlock.data(), end, '\n'));
+  }
+  state.SetBytesProcessed(state.iterations() * kBlock.size());
+}
+BENCHMARK(BM_FindByte)->DenseRange(0, 2);
+
+static void BM_FindAnyOf(benchmark::State& state) {
+  if (!selectIsa(state)) {
+    return;
+  }
+  const char* end = kBlock.data() + kBlock.size();
+  const char kSet[] = {' ', ':', '\r', '\n'};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        scan::findAnyOf(kBlock.data(), end, kSet, sizeof(kSet)));
+  }
+  state.SetBytesProcessed(state.iterations() * kBlock.size());
+}
+BENCHMARK(BM_FindAnyOf)->DenseRange(0, 2);
+
+static void BM_FindCrlf(benchmark::State& state) {
+  if (!selectIsa(state)) {
+    return;
+  }
+  const char* end = kBlock.data() + kBlock.size();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(scan::findCrlf(kBlock.data(), end));
+  }
+  state.SetBytesProcessed(state.iterations() * kBlock.size());
+}
+BENCHMARK(BM_FindCrlf)->DenseRange(0, 2);
+
+}  // namespace coro
+
+BENCHMARK_MAIN();
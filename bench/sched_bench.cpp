@@ -0,0 +1,80 @@
+#include <benchmark/benchmark.h>
+
+#include "common.hpp"
+#include "coro/promise.hpp"
+#include "coro/sched.hpp"
+#include "coro/spawn.hpp"
+
+namespace coro {
+
+// 主协程和另一个协程轮流 yield，每次迭代包含两次上下文切换（Coro::resume）。
+static void BM_Resume(benchmark::State& state) {
+  bool stop = false;
+  auto promise = spawn([&stop]() {
+    while (!stop) {
+      yield();
+    }
+  });
+  yield();
+  {
+    bench::AllocCounter counter(state);
+    for (auto _ : state) {
+      yield();
+    }
+  }
+  stop = true;
+  promise.await();
+  state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_Resume);
+
+// 创建协程、运行到结束并等待其结果。
+static void BM_Spawn(benchmark::State& state) {
+  bench::AllocCounter counter(state);
+  for (auto _ : state) {
+    int result = spawn([]() { return 1; }).await();
+    benchmark::DoNotOptimize(result);
+  }
+}
+BENCHMARK(BM_Spawn);
+
+// 等待一个已经兑现的 Promise，不发生上下文切换。
+static void BM_PromiseResolveAwait(benchmark::State& state) {
+  bench::AllocCounter counter(state);
+  for (auto _ : state) {
+    Promise<int> promise;
+    promise.resolve(1);
+    int result = promise.await();
+    benchmark::DoNotOptimize(result);
+  }
+}
+BENCHMARK(BM_PromiseResolveAwait);
+
+// 主协程阻塞在 Promise 上，由另一个协程兑现后唤醒。
+static void BM_PromiseWakeUp(benchmark::State& state) {
+  // 未敲定的 Promise 不能被析构，所以初始的 Promise 是已兑现的。
+  Promise<int> pending;
+  pending.resolve(0);
+  bool stop = false;
+  auto resolver = spawn([&pending, &stop]() {
+    while (!stop) {
+      pending.resolve(1);
+      yield();
+    }
+  });
+  {
+    bench::AllocCounter counter(state);
+    for (auto _ : state) {
+      pending = Promise<int>();
+      int result = pending.await();
+      benchmark::DoNotOptimize(result);
+    }
+  }
+  stop = true;
+  resolver.await();
+}
+BENCHMARK(BM_PromiseWakeUp);
+
+}  // namespace coro
+
+BENCHMARK_MAIN();
@@ -0,0 +1,49 @@
+#include <benchmark/benchmark.h>
+
+#include "common.hpp"
+
+namespace coro {
+
+static const char kLines[] =
+    "PING\r\n"
+    "GET /index.html HTTP/1.1\r\n"
+    "Host: example.com\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9\r\n"
+    "\r\n";
+static constexpr size_t kLineCount = 6;
+
+// 从内存流中逐行读取，覆盖 readline 和流缓冲区的开销。
+static void BM_Readline(benchmark::State& state) {
+  Stream stream = std::make_shared<bench::LoopStream>(kLines);
+  char buf[4096];
+  {
+    bench::AllocCounter counter(state);
+    for (auto _ : state) {
+      size_t n = stream->readline(buf, sizeof(buf)).await();
+      benchmark::DoNotOptimize(n);
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * (sizeof(kLines) - 1) /
+                          kLineCount);
+}
+BENCHMARK(BM_Readline);
+
+// 读取固定长度的数据。
+static void BM_Readn(benchmark::State& state) {
+  Stream stream = std::make_shared<bench::LoopStream>(kLines);
+  char buf[64];
+  {
+    bench::AllocCounter counter(state);
+    for (auto _ : state) {
+      size_t n = stream->readn(buf, sizeof(buf)).await();
+      benchmark::DoNotOptimize(n);
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * sizeof(buf));
+}
+BENCHMARK(BM_Readn);
+
+}  // namespace coro
+
+BENCHMARK_MAIN();
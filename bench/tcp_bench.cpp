@@ -0,0 +1,417 @@
+#include <arpa/inet.h>
+#include <benchmark/benchmark.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "common.hpp"
+#include "coro/http.hpp"
+#include "coro/pump.hpp"
+#include "coro/sched/sched.hpp"
+#include "coro/spawn.hpp"
+#include "coro/tcp.hpp"
+
+// 经过内核回环网卡的往返，Asio 的 IO 后端名称显示在每项结果的标签中。
+
+namespace coro {
+
+// echo 服务端和客户端在同一线程中，每次迭代发送一行并读回。
+static void BM_TcpEcho(benchmark::State& state) {
+  auto listener = tcp::listen(0);
+  auto server = spawn([listener]() {
+    auto conn = listener->accept().await();
+    char buf[256];
+    for (;;) {
+      size_t n = conn->readline(buf, sizeof(buf)).await();
+      if (n == 0) {
+        break;
+      }
+      conn->write(buf, n).await();
+    }
+  });
+
+  auto conn = tcp::connect("127.0.0.1", listener->port()).await();
+  const char line[] = "hello, world\n";
+  char buf[256];
+  {
+    bench::AllocCounter counter(state);
+    for (auto _ : state) {
+      conn->write(line, strlen(line)).await();
+      size_t n = conn->readline(buf, sizeof(buf)).await();
+      benchmark::DoNotOptimize(n);
+    }
+  }
+  conn->close();
+  std::error_code error;
+  server.await(&error);
+  state.SetLabel(sched::ioBackend());
+}
+BENCHMARK(BM_TcpEcho);
+
+// 一次完整的 HTTP 请求，与 http_server 示例相同，响应带有正文。
+static void BM_TcpHttp(benchmark::State& state) {
+  auto listener = tcp::listen(0);
+  auto server = spawn([listener]() {
+    Stream conn = listener->accept().await();
+    http::protocol::Response resp;
+    resp.version = "HTTP/1.1";
+    resp.code = 200;
+    resp.reason = "OK";
+    const char body[] = "<h1>Hello</h1>";
+    resp.headers = {{"Content-Type", "text/html"},
+                    {"Content-Length", std::to_string(strlen(body))}};
+    for (;;) {
+      auto req = http::protocol::readReq(conn).await();
+      http::protocol::writeResp(conn, resp, body).await();
+    }
+  });
+
+  Stream conn = tcp::connect("127.0.0.1", listener->port()).await();
+  http::protocol::Request req;
+  req.method = "GET";
+  req.url = "/index.html";
+  req.version = "HTTP/1.1";
+  req.headers = {{"Host", "example.com"}, {"Accept", "text/html"}};
+  char body[64];
+  {
+    bench::AllocCounter counter(state);
+    for (auto _ : state) {
+      http::protocol::writeReq(conn, req).await();
+      auto resp = http::protocol::readResp(conn).await();
+      conn->readn(body, strlen("<h1>Hello</h1>")).await();
+      benchmark::DoNotOptimize(resp);
+    }
+  }
+  conn->close();
+  std::error_code error;
+  server.await(&error);
+  state.SetLabel(sched::ioBackend());
+}
+BENCHMARK(BM_TcpHttp);
+
+// 服务端每次收到请求后发送整个文件，比较 sendfile 与先读入用户态再写出。
+static void BM_TcpFile(benchmark::State& state, bool zero_copy) {
+  size_t size = state.range(0);
+  char path[] = "/tmp/coro_tcp_bench_XXXXXX";
+  int fd = mkstemp(path);
+  unlink(path);
+  std::string data(size, 'x');
+  if (fd < 0 || ::write(fd, data.data(), size) != static_cast<ssize_t>(size)) {
+    state.SkipWithError("failed to create the file");
+    return;
+  }
+
+  auto listener = tcp::listen(0);
+  auto server = spawn([listener, fd, size, zero_copy]() {
+    auto conn = listener->accept().await();
+    std::unique_ptr<char[]> buf(zero_copy ? nullptr : new char[size]);
+    char chr;
+    while (conn->read(&chr, 1).await() == 1) {
+      if (zero_copy) {
+        conn->sendFile(fd, 0, size).await();
+      } else {
+        pread(fd, buf.get(), size, 0);
+        conn->write(buf.get(), size).await();
+      }
+    }
+  });
+
+  auto conn = tcp::connect("127.0.0.1", listener->port()).await();
+  std::unique_ptr<char[]> buf(new char[size]);
+  for (auto _ : state) {
+    conn->write("x", 1).await();
+    conn->readn(buf.get(), size).await();
+  }
+  conn->close();
+  std::error_code error;
+  server.await(&error);
+  close(fd);
+  state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK_CAPTURE(BM_TcpFile, sendfile, true)->Arg(64 << 10)->Arg(4 << 20);
+BENCHMARK_CAPTURE(BM_TcpFile, read_write, false)->Arg(64 << 10)->Arg(4 << 20);
+
+// 经过代理的单向吞吐量：a 的数据由代理转发给 b。比较 pump（splice）
+// 与每个方向一个协程、用栈上缓冲区逐次读写的实现。
+static void BM_TcpProxy(benchmark::State& state, bool use_pump) {
+  size_t size = state.range(0);
+  auto listener = tcp::listen(0);
+  auto accept = spawn([listener]() { return listener->accept().await(); });
+  auto client_a = tcp::connect("127.0.0.1", listener->port()).await();
+  auto server_a = accept.await();
+  accept = spawn([listener]() { return listener->accept().await(); });
+  auto client_b = tcp::connect("127.0.0.1", listener->port()).await();
+  auto server_b = accept.await();
+
+  auto proxy = spawn([server_a, server_b, use_pump]() {
+    if (use_pump) {
+      pump(server_a, server_b).await();
+      return;
+    }
+    char buf[16 * 1024];
+    for (;;) {
+      size_t n = server_a->read(buf, sizeof(buf)).await();
+      server_b->write(buf, n).await();
+    }
+  });
+
+  std::string data(size, 'x');
+  std::unique_ptr<char[]> buf(new char[size]);
+  for (auto _ : state) {
+    auto writer = spawn([client_a, &data]() {
+      client_a->write(data.data(), data.size()).await();
+    });
+    client_b->readn(buf.get(), size).await();
+    writer.await();
+  }
+  client_a->close();
+  client_b->close();
+  std::error_code error;
+  proxy.await(&error);
+  state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK_CAPTURE(BM_TcpProxy, pump, true)->Arg(64 << 10)->Arg(4 << 20);
+BENCHMARK_CAPTURE(BM_TcpProxy, read_write, false)->Arg(64 << 10)->Arg(4 << 20);
+
+// 将当前线程固定在 CPU index % CPU 个数上。
+static void pinThread(size_t index) {
+  size_t cpus = std::thread::hardware_concurrency();
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(index % (cpus > 0 ? cpus : 1), &set);
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+/**
+ * @brief BM_TcpEchoScaling 的服务端配置。
+ */
+enum class Accept {
+  kSingle,       // 只有一个线程监听。
+  kReusePort,    // 每个线程各自监听同一端口，由内核按四元组的哈希分配连接。
+  kCpuSteering,  // 在 kReusePort 的基础上，按处理 SYN 的 CPU 分配连接。
+};
+
+// 启动 threads 个 echo 服务端线程（与 echo_server 示例相同），返回端口。
+// kCpuSteering 时第 i 个服务端线程固定在 CPU i % CPU 个数上，
+// 连接由与客户端在同一 CPU 上的服务端线程接受。
+// 服务端线程无法从外部停止，每种配置只启动一次，随进程退出。
+static uint16_t echoServers(size_t threads, Accept accept) {
+  static std::mutex mutex;
+  static std::map<std::pair<size_t, Accept>, uint16_t> ports;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = ports.find({threads, accept});
+  if (it != ports.end()) {
+    return it->second;
+  }
+
+  // 组中下标不小于 CPU 个数的监听套接字收不到连接，组的大小不超过 CPU 个数。
+  unsigned group = std::min<unsigned>(
+      threads, std::max(std::thread::hardware_concurrency(), 1u));
+  uint16_t port = 0;
+  for (size_t i = 0; i < (accept == Accept::kSingle ? 1 : threads); i++) {
+    std::promise<uint16_t> listening;
+    std::thread([i, port, accept, group, &listening]() {
+      tcp::ListenOptions options;
+      options.reuse_port = accept != Accept::kSingle;
+      if (accept == Accept::kCpuSteering) {
+        pinThread(i);
+        options.cpu_steering_group = group;
+      }
+      auto listener = tcp::listen("127.0.0.1", port, options);
+      listening.set_value(listener->port());
+      for (;;) {
+        auto conn = listener->accept().await();
+        spawn([conn]() {
+          char buf[256];
+          for (;;) {
+            std::error_code error;
+            size_t n = conn->readline(buf, sizeof(buf)).await(&error);
+            if (n == 0 || error) {
+              break;
+            }
+            conn->write(buf, n).await();
+          }
+        });
+      }
+    }).detach();
+    port = listening.get_future().get();
+  }
+  ports[{threads, accept}] = port;
+  return port;
+}
+
+// 每个基准测试线程一个客户端连接，服务端线程数与客户端线程数相同。
+// 比较 SO_REUSEPORT 的多个监听线程、按 CPU 分配连接与所有连接都由一个线程处理。
+// kCpuSteering 时第 i 个客户端线程与第 i 个服务端线程固定在同一 CPU 上。
+static void BM_TcpEchoScaling(benchmark::State& state, Accept accept) {
+  uint16_t port = echoServers(state.threads(), accept);
+  // 0 号基准测试线程可能是主线程，结束后恢复原来的 CPU 集合。
+  cpu_set_t original;
+  pthread_getaffinity_np(pthread_self(), sizeof(original), &original);
+  if (accept == Accept::kCpuSteering) {
+    pinThread(state.thread_index());
+  }
+  auto conn = tcp::connect("127.0.0.1", port).await();
+  const char line[] = "hello, world\n";
+  char buf[256];
+  for (auto _ : state) {
+    conn->write(line, strlen(line)).await();
+    size_t n = conn->readline(buf, sizeof(buf)).await();
+    benchmark::DoNotOptimize(n);
+  }
+  conn->close();
+  pthread_setaffinity_np(pthread_self(), sizeof(original), &original);
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_CAPTURE(BM_TcpEchoScaling, reuse_port, Accept::kReusePort)
+    ->ThreadRange(1, 8)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(BM_TcpEchoScaling, cpu_steering, Accept::kCpuSteering)
+    ->ThreadRange(1, 8)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(BM_TcpEchoScaling, single_acceptor, Accept::kSingle)
+    ->ThreadRange(1, 8)
+    ->UseRealTime();
+
+// 每次迭代先建立 state.range(0) 个连接（不计时），再由服务端全部接受。
+// 比较逐个 accept 与 acceptBatch。客户端用 SO_LINGER 为 0 的方式关闭，
+// 不留下 TIME_WAIT，避免耗尽端口。
+static void BM_TcpAccept(benchmark::State& state, bool batch) {
+  size_t count = state.range(0);
+  auto listener = tcp::listen(0);
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(listener->port());
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  linger reset = {1, 0};
+
+  std::vector<int> fds;
+  std::vector<tcp::Conn> conns;
+  for (auto _ : state) {
+    state.PauseTiming();
+    for (size_t i = 0; i < count; i++) {
+      int fd = socket(AF_INET, SOCK_STREAM, 0);
+      setsockopt(fd, SOL_SOCKET, SO_LINGER, &reset, sizeof(reset));
+      // 回环上的 connect 在内核中完成握手，无需服务端参与。
+      connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+      fds.push_back(fd);
+    }
+    state.ResumeTiming();
+
+    if (batch) {
+      while (conns.size() < count) {
+        auto accepted = listener->acceptBatch(count - conns.size()).await();
+        conns.insert(conns.end(), accepted.begin(), accepted.end());
+      }
+    } else {
+      while (conns.size() < count) {
+        conns.push_back(listener->accept().await());
+      }
+    }
+
+    state.PauseTiming();
+    conns.clear();
+    for (int fd : fds) {
+      close(fd);
+    }
+    fds.clear();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK_CAPTURE(BM_TcpAccept, accept, false)->Arg(64);
+BENCHMARK_CAPTURE(BM_TcpAccept, accept_batch, true)->Arg(64);
+
+/**
+ * @brief BM_TcpRpc 各项使用的套接字选项，除 default 外都关闭 Nagle 算法，
+ * 以便单独比较其他选项。
+ */
+static tcp::SocketOptions rpcOptions(const std::string& name) {
+  tcp::SocketOptions options;
+  options.no_delay = name != "default";
+  if (name == "quick_ack") {
+    options.quick_ack = true;
+  } else if (name == "busy_poll") {
+    options.busy_poll = 50;
+  } else if (name == "not_sent_lowat") {
+    options.not_sent_lowat = 16 * 1024;
+  } else if (name == "buffers") {
+    options.send_buffer = 256 * 1024;
+    options.receive_buffer = 256 * 1024;
+  } else if (name == "fast_open") {
+    options.fast_open = true;
+  } else if (name == "keepalive") {
+    options.keepalive_idle = 60;
+    options.keepalive_interval = 10;
+    options.keepalive_count = 3;
+  }
+  return options;
+}
+
+// 请求和响应都由 4 字节的长度和 state.range(0) 字节的消息体组成，分两次写入，
+// 测量一次往返的延迟。两端使用相同的选项，服务端的选项由监听套接字继承。
+// 未设置 no_delay 时第二次写入要等待对端延迟确认第一次写入（Nagle 算法）。
+static void BM_TcpRpc(benchmark::State& state, const std::string& name) {
+  tcp::ListenOptions listen_options;
+  listen_options.socket = rpcOptions(name);
+  std::error_code error;
+  auto listener = tcp::listen("127.0.0.1", 0, listen_options, &error);
+  if (error) {
+    state.SkipWithError(error.message().c_str());
+    return;
+  }
+  auto server = spawn([listener]() {
+    auto conn = listener->accept().await();
+    std::string body;
+    for (;;) {
+      uint32_t len;
+      conn->readn(reinterpret_cast<char*>(&len), sizeof(len)).await();
+      body.resize(len);
+      conn->readn(&body[0], len).await();
+      conn->write(reinterpret_cast<const char*>(&len), sizeof(len)).await();
+      conn->write(body.data(), len).await();
+    }
+  });
+
+  auto conn =
+      tcp::connect("127.0.0.1", listener->port(), rpcOptions(name)).await();
+  uint32_t len = state.range(0);
+  std::string request(len, 'x');
+  std::string response(len, '\0');
+  for (auto _ : state) {
+    conn->write(reinterpret_cast<const char*>(&len), sizeof(len)).await();
+    conn->write(request.data(), len).await();
+    uint32_t n;
+    conn->readn(reinterpret_cast<char*>(&n), sizeof(n)).await();
+    conn->readn(&response[0], n).await();
+  }
+  conn->close();
+  server.await(&error);
+  state.SetLabel(sched::ioBackend());
+}
+BENCHMARK_CAPTURE(BM_TcpRpc, default, std::string("default"))->Arg(64);
+BENCHMARK_CAPTURE(BM_TcpRpc, no_delay, std::string("no_delay"))->Arg(64);
+BENCHMARK_CAPTURE(BM_TcpRpc, quick_ack, std::string("quick_ack"))->Arg(64);
+BENCHMARK_CAPTURE(BM_TcpRpc, busy_poll, std::string("busy_poll"))->Arg(64);
+BENCHMARK_CAPTURE(BM_TcpRpc, not_sent_lowat, std::string("not_sent_lowat"))
+    ->Arg(64);
+BENCHMARK_CAPTURE(BM_TcpRpc, buffers, std::string("buffers"))->Arg(64);
+BENCHMARK_CAPTURE(BM_TcpRpc, fast_open, std::string("fast_open"))->Arg(64);
+BENCHMARK_CAPTURE(BM_TcpRpc, keepalive, std::string("keepalive"))->Arg(64);
+
+}  // namespace coro
+
+BENCHMARK_MAIN();
@@ -0,0 +1,9 @@
+for _, name in ipairs({"arena", "http", "redis", "scan", "sched", "stream", "tcp"}) do
+    target("bench_" .. name)
+        set_kind("binary")
+        set_group("bench")
+        add_files(name .. "_bench.cpp", "common.cpp")
+        add_includedirs("$(projectdir)/include")
+        add_deps("coro")
+        add_packages("boost", "benchmark")
+end
@@ -1,27 +1,46 @@
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
 #include "coro/coro.hpp"
 
 using coro::spawn;
 using coro::tcp::Conn;
 using coro::tcp::listen;
+using coro::tcp::ListenOptions;
 
 void handler(Conn conn) {
+  // 空闲的连接不占用读缓冲区。
+  conn->setPooledReadBuffer(true);
   for (;;) {
-    char buf[4096];
-    auto n = conn->readline(buf, 4096).await();
-    if (n == 0) {
+    auto line = conn->readUntil('\n', 4096).await();
+    if (line.empty()) {
       conn->close();
       break;
     }
-    conn->write(buf, n).await();
+    conn->write(line.data(), line.size()).await();
   }
 }
 
-int main() {
-  auto listener = listen(8080);
+void serve() {
+  // 每个线程各自监听 8080 端口，由内核在线程之间分配新连接。
+  ListenOptions options;
+  options.reuse_port = true;
+  auto listener = listen("127.0.0.1", 8080, options);
   for (;;) {
     auto conn = listener->accept().await();
     spawn([conn]() { handler(conn); });
   }
+}
+
+int main(int argc, char* argv[]) {
+  // 第一个参数为线程数，默认为 1。
+  int threads = argc > 1 ? atoi(argv[1]) : 1;
+  std::vector<std::thread> workers;
+  for (int i = 1; i < threads; i++) {
+    workers.emplace_back(serve);
+  }
+  serve();
 
   return 0;
 }
@@ -1,3 +1,4 @@
+#include <chrono>
 #include <string>
 
 #include "coro/coro.hpp"
@@ -8,6 +9,7 @@ using coro::http::protocol::Response;
 using coro::http::protocol::writeResp;
 using coro::tcp::Conn;
 using coro::tcp::listen;
+using coro::tcp::ServeOptions;
 using std::string;
 using std::to_string;
 
@@ -20,17 +22,28 @@ void handler(Conn conn) {
   string body = "<h1>You are accessing " + req.url + " </h1>";
   resp.headers = {{"Content-Type", "text/html"},
                   {"Content-Length", to_string(body.length())}};
+  writeResp(conn, resp, body).await();
+  conn->close();
+}
+
+// 过载时直接返回 503，不读取请求。
+void shed(Conn conn) {
+  Response resp;
+  resp.code = 503;
+  resp.reason = "Service Unavailable";
+  resp.version = "HTTP/1.1";
+  resp.headers = {{"Content-Length", "0"}, {"Connection", "close"}};
   writeResp(conn, resp).await();
-  conn->write(body.data(), body.length());
   conn->close();
 }
 
 int main() {
   auto listener = listen(8080);
-  for (;;) {
-    auto conn = listener->accept().await();
-    spawn([conn]() { handler(conn); });
-  }
+  ServeOptions options;
+  options.max_conns = 10000;
+  options.shed_target = std::chrono::milliseconds(5);
+  options.shed_handler = shed;
+  listener->serve(handler, options).await();
 
   return 0;
 }
\ No newline at end of file
@@ -0,0 +1,108 @@
+#ifndef CORO_INCLUDE_CORO_ARENA_HPP_
+#define CORO_INCLUDE_CORO_ARENA_HPP_
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "sched/arena.hpp"
+#include "sched/sched.hpp"
+
+namespace coro {
+
+/**
+ * @brief 为当前协程启用 Arena，之后在该协程中构造的 ArenaAllocator
+ * 都从该 Arena 分配内存。协程退出时 Arena 被整体释放。
+ * @param block_size Arena 内存块大小。
+ * @param max_blocks Arena 最多持有的内存块数。
+ */
+inline void enableArena(size_t block_size = sched::kDefaultArenaBlockSize,
+                        size_t max_blocks = sched::kDefaultArenaMaxBlocks) {
+  sched::Coro* coro = sched::currentPtr();
+  if (!coro->arena()) {
+    coro->setArena(std::make_shared<sched::Arena>(block_size, max_blocks));
+  }
+}
+
+/**
+ * @brief 兼容 STL 的分配器。默认构造时绑定当前协程的 Arena，
+ * 如果当前协程未启用 Arena，则退化为 operator new。
+ * 分配器持有 Arena 的引用，因此分配出的对象可以安全地比协程活得更久。
+ * @tparam T 分配的对象类型。
+ */
+template <typename T>
+class ArenaAllocator {
+ public:
+  using value_type = T;
+
+  ArenaAllocator() : arena_(sched::currentPtr()->arena()) {}
+  explicit ArenaAllocator(std::shared_ptr<sched::Arena> arena)
+      : arena_(std::move(arena)) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other)  // NOLINT
+      : arena_(other.arena()) {}
+
+  T* allocate(size_t n) {
+    if (arena_) {
+      return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+    }
+    return static_cast<T*>(::operator new(n * sizeof(T)));
+  }
+
+  void deallocate(T* ptr, size_t n) {
+    if (arena_) {
+      arena_->deallocate(ptr);
+    } else {
+      ::operator delete(ptr);
+    }
+  }
+
+  const std::shared_ptr<sched::Arena>& arena() const { return arena_; }
+
+ private:
+  std::shared_ptr<sched::Arena> arena_;  // 为 nullptr 表示使用 operator new。
+};
+
+template <typename T, typename U>
+inline bool operator==(const ArenaAllocator<T>& lhs,
+                       const ArenaAllocator<U>& rhs) {
+  return lhs.arena() == rhs.arena();
+}
+
+template <typename T, typename U>
+inline bool operator!=(const ArenaAllocator<T>& lhs,
+                       const ArenaAllocator<U>& rhs) {
+  return !(lhs == rhs);
+}
+
+/**
+ * @brief 构造一个由 std::shared_ptr 持有的对象，对象和控制块一起从当前协程的
+ * Arena 中分配。
+ * @tparam T 对象类型。
+ * @param args 构造函数的参数。
+ * @return std::shared_ptr<T> 构造的对象。
+ */
+template <typename T, typename... Args>
+inline std::shared_ptr<T> makeShared(Args&&... args) {
+  return std::allocate_shared<T>(ArenaAllocator<T>(),
+                                 std::forward<Args>(args)...);
+}
+
+/**
+ * @brief 分配一个由 std::shared_ptr 持有的字节缓冲区，
+ * 缓冲区从当前协程的 Arena 中分配。
+ * @param size 缓冲区大小。
+ * @return std::shared_ptr<char> 缓冲区。
+ */
+inline std::shared_ptr<char> makeSharedBuffer(size_t size) {
+  ArenaAllocator<char> alloc;
+  char* buf = alloc.allocate(size);
+  return std::shared_ptr<char>(
+      buf, [alloc, size](char* ptr) mutable { alloc.deallocate(ptr, size); },
+      alloc);
+}
+
+}  // namespace coro
+
+#endif  // CORO_INCLUDE_CORO_ARENA_HPP_
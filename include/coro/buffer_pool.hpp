@@ -0,0 +1,101 @@
+#ifndef CORO_INCLUDE_CORO_BUFFER_POOL_HPP_
+#define CORO_INCLUDE_CORO_BUFFER_POOL_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace coro {
+
+// 最小的尺寸类，单位字节。更小的请求也分配该大小的缓冲区。
+static constexpr size_t kMinPooledBufferSize = 256;
+// 最大的尺寸类，单位字节。更大的缓冲区不经过池，直接分配和释放。
+static constexpr size_t kMaxPooledBufferSize = 64 * 1024;
+// 池中空闲缓冲区的总大小的默认上限，单位字节。
+static constexpr size_t kDefaultMaxCachedBytes = 16 * 1024 * 1024;
+
+/**
+ * @brief 缓冲区池的统计数据。
+ */
+struct BufferPoolStats {
+  uint64_t hits = 0;       // 从池中取出空闲缓冲区的次数。
+  uint64_t misses = 0;     // 池中没有空闲缓冲区而新分配的次数。
+  uint64_t oversized = 0;  // 超过最大尺寸类而直接分配的次数。
+  uint64_t drops = 0;      // 归还时因超过上限而直接释放的次数。
+  size_t cached_buffers = 0;  // 池中空闲的缓冲区个数。
+  size_t cached_bytes = 0;    // 池中空闲的缓冲区的总大小。
+
+  /**
+   * @brief 计算命中率。
+   * @return double 命中次数占全部取出次数的比例，没有取出过时返回 0。
+   */
+  double hitRate() const {
+    uint64_t total = hits + misses + oversized;
+    return total == 0 ? 0 : static_cast<double>(hits) / total;
+  }
+};
+
+/**
+ * @brief 按尺寸类缓存缓冲区的池，每个调度器一个，只能在其所属的线程中使用。
+ * 尺寸类是从 kMinPooledBufferSize 到 kMaxPooledBufferSize 的 2 的幂，
+ * 取出的缓冲区的大小向上取整到尺寸类，每个尺寸类有一个空闲链表。
+ * 流在等待数据时将读缓冲区归还给池，数据到达时再取出，
+ * 因此大量空闲连接只占用与活跃连接数相当的读缓冲区。
+ */
+class BufferPool {
+ public:
+  /**
+   * @brief 构造一个空的缓冲区池，缓冲区在第一次取出时才分配。
+   * @param max_cached_bytes 池中空闲缓冲区的总大小的上限。
+   */
+  explicit BufferPool(size_t max_cached_bytes = kDefaultMaxCachedBytes);
+
+  // 禁止拷贝和移动，BufferPool 由 Scheduler 持有。
+  BufferPool(const BufferPool&) = delete;
+  BufferPool& operator=(const BufferPool&) = delete;
+  BufferPool(BufferPool&&) = delete;
+  BufferPool& operator=(BufferPool&&) = delete;
+
+  /**
+   * @brief 取出一个至少 size 个字节的缓冲区，池中没有空闲缓冲区时新分配。
+   * @param size 需要的字节数。
+   * @return std::unique_ptr<char[]> 大小为 capacityFor(size) 的缓冲区。
+   */
+  std::unique_ptr<char[]> acquire(size_t size);
+
+  /**
+   * @brief 归还一个缓冲区。空闲缓冲区的总大小将超过上限时直接释放。
+   * @param buf 由 acquire 取出的缓冲区。
+   * @param size 取出时的 size 或缓冲区的实际大小。
+   */
+  void release(std::unique_ptr<char[]> buf, size_t size);
+
+  /**
+   * @brief 获取 size 所属的尺寸类的大小。
+   * @param size 需要的字节数。
+   * @return size_t 尺寸类的大小，超过最大尺寸类时返回 size。
+   */
+  static size_t capacityFor(size_t size);
+
+  /**
+   * @brief 获取统计数据。
+   * @return BufferPoolStats 统计数据。
+   */
+  const BufferPoolStats& stats() const { return stats_; }
+
+ private:
+  /**
+   * @brief 获取 size 所属的尺寸类的下标。size 不能超过最大尺寸类。
+   */
+  static size_t classIndex(size_t size);
+
+  size_t max_cached_bytes_;  // 空闲缓冲区的总大小的上限。
+  // 每个尺寸类的空闲缓冲区，按尺寸类从小到大排列。
+  std::vector<std::vector<std::unique_ptr<char[]>>> free_;
+  BufferPoolStats stats_;  // 统计数据。
+};
+
+}  // namespace coro
+
+#endif  // CORO_INCLUDE_CORO_BUFFER_POOL_HPP_
@@ -0,0 +1,161 @@
+#ifndef CORO_INCLUDE_CORO_BUFFERED_WRITER_HPP_
+#define CORO_INCLUDE_CORO_BUFFERED_WRITER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <system_error>
+
+#include "promise.hpp"
+#include "stream.hpp"
+
+namespace coro {
+
+// 缓冲区中的数据达到该大小时立即写入底层流，单位字节。
+static constexpr size_t kDefaultFlushThreshold = 16 * 1024;
+// 缓冲区的默认上限，单位字节。
+static constexpr size_t kDefaultWriteBufferLimit = 256 * 1024;
+
+namespace impl {
+
+/**
+ * @brief 合并小块写入的流，包装另一个流。
+ * write 只将数据追加到缓冲区并立即敲定，缓冲区中的数据在以下时机写入底层流：
+ * 数据量达到阈值时；调用 flush() 时；调度器空闲（所有协程都在等待）时。
+ * 因此同一轮调度中多个协程的小块写入只需一次系统调用。
+ * 写入底层流期间到达的数据在本次写入完成后一起写入。
+ * 缓冲区超过上限时，写入方阻塞直至数据被写入底层流。
+ * 读取操作直接转发给底层流。
+ */
+class BufferedWriter : public Stream,
+                       public std::enable_shared_from_this<BufferedWriter> {
+ public:
+  /**
+   * @brief 构造 BufferedWriter，应当使用 bufferWrites() 创建。
+   * @param stream 底层流。
+   * @param threshold 立即写入底层流的阈值。
+   * @param limit 缓冲区的上限，不能小于 threshold。
+   */
+  BufferedWriter(coro::Stream stream, size_t threshold, size_t limit)
+      : stream_(std::move(stream)), threshold_(threshold), limit_(limit) {}
+
+  /**
+   * @brief 将 len 个字节追加到缓冲区。缓冲区已满时阻塞直至有足够的空间，
+   * 单次写入超过上限时阻塞直至缓冲区为空。
+   * 之前写入底层流出错时 Promise 被拒绝，错误码与底层流的错误相同。
+   * @param buf 缓冲区，Promise 敲定后即可释放。
+   * @param len 缓冲区大小。
+   * @return Promise<size_t> 写入的字节数。
+   */
+  Promise<size_t> write(const char* buf, size_t len) override;
+
+  /**
+   * @brief 将缓冲区中的数据写入底层流。
+   * @return Promise<void> 调用之前写入的数据全部写入底层流后敲定。
+   */
+  Promise<void> flush();
+
+  /**
+   * @brief 关闭底层流，尚未写入底层流的数据被丢弃，应当先调用 flush()。
+   */
+  void close() override { stream_->close(); }
+
+  /**
+   * @brief 将缓冲区中的数据写入底层流后，关闭底层流的写方向。
+   */
+  void shutdownWrite() override;
+
+  /**
+   * @brief 获取尚未写入底层流的字节数。
+   * @return size_t 尚未写入底层流的字节数，包括正在写入的数据。
+   */
+  size_t buffered() const { return appended_ - written_; }
+
+ protected:
+  /**
+   * @brief 从底层流读取最多 len 个字节。
+   * @param buf 缓冲区。
+   * @param len 缓冲区大小。
+   * @return Promise<size_t> 读取到的字节数，可能小于 len。
+   */
+  Promise<size_t> readSome(char* buf, size_t len) override {
+    return stream_->read(buf, len);
+  }
+
+ private:
+  /**
+   * @brief 因缓冲区已满而阻塞的写入。
+   */
+  struct BlockedWrite {
+    const char* buf;
+    size_t len;
+    Promise<size_t> promise;
+  };
+
+  /**
+   * @brief 等待数据写入底层流的 flush。
+   */
+  struct FlushWaiter {
+    uint64_t target;  // 累计写入底层流的字节数达到该值时敲定。
+    Promise<void> promise;
+  };
+
+  /**
+   * @brief 缓冲区能否容纳 len 个字节。
+   */
+  bool fits(size_t len) const {
+    return pending_.empty() || pending_.size() + len <= limit_;
+  }
+
+  /**
+   * @brief 将 pending_ 中的数据写入底层流。
+   */
+  void startFlush();
+
+  /**
+   * @brief 将 inflight_ 中从 inflight_offset_ 开始的数据写入底层流。
+   */
+  void writeInflight();
+
+  /**
+   * @brief 写入底层流完成时调用。
+   * @param n 写入的字节数。
+   * @param error 错误码。
+   */
+  void onFlushed(size_t n, std::error_code error);
+
+  coro::Stream stream_;                // 底层流。
+  size_t threshold_;                   // 立即写入底层流的阈值。
+  size_t limit_;                       // 缓冲区的上限。
+  std::string pending_;                // 等待写入底层流的数据。
+  std::string inflight_;               // 正在写入底层流的数据。
+  size_t inflight_offset_ = 0;         // inflight_ 中已经写入底层流的字节数。
+  bool flushing_ = false;              // 是否正在写入底层流。
+  bool idle_flush_scheduled_ = false;  // 是否已注册空闲任务。
+  uint64_t appended_ = 0;              // 累计追加到缓冲区的字节数。
+  uint64_t written_ = 0;               // 累计写入底层流的字节数。
+  std::error_code error_;              // 写入底层流时发生的错误。
+  std::deque<BlockedWrite> blocked_writes_;
+  std::deque<FlushWaiter> flush_waiters_;
+};
+
+}  // namespace impl
+
+using BufferedWriter = std::shared_ptr<impl::BufferedWriter>;
+
+/**
+ * @brief 创建合并小块写入的 BufferedWriter，之后应当只通过它写入 stream。
+ * @param stream 底层流。
+ * @param threshold 缓冲区中的数据达到该大小时立即写入底层流。
+ * @param limit 缓冲区的上限，超过时写入方阻塞。
+ * @return BufferedWriter 包装 stream 的流。
+ */
+BufferedWriter bufferWrites(Stream stream,
+                            size_t threshold = kDefaultFlushThreshold,
+                            size_t limit = kDefaultWriteBufferLimit);
+
+}  // namespace coro
+
+#endif  // CORO_INCLUDE_CORO_BUFFERED_WRITER_HPP_
@@ -1,9 +1,14 @@
 #ifndef CORO_INCLUDE_CORO_CORO_HPP_
 #define CORO_INCLUDE_CORO_CORO_HPP_
 
+#include "buffer_pool.hpp"
+#include "buffered_writer.hpp"
 #include "exception.hpp"
 #include "http.hpp"
+#include "local.hpp"
+#include "pipe.hpp"
 #include "promise.hpp"
+#include "pump.hpp"
 #include "redis.hpp"
 #include "sched.hpp"
 #include "sleep.hpp"
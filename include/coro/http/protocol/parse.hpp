@@ -1,19 +1,23 @@
 #ifndef CORO_INCLUDE_CORO_HTTP_PROTOCOL_PARSE_HPP_
 #define CORO_INCLUDE_CORO_HTTP_PROTOCOL_PARSE_HPP_
 
+#include <cstddef>
 #include <string>
 
 namespace coro {
 namespace http {
 namespace protocol {
 
-bool parseReqStartLine(const char* line, std::string& method, std::string& url,
-                       std::string& version);
+// 以下函数解析以 \n 结尾的一行，len 为包括 \n 在内的长度。
 
-bool parseRespStartLine(const char* line, std::string& version, int& code,
-                        std::string& reason);
+bool parseReqStartLine(const char* line, size_t len, std::string& method,
+                       std::string& url, std::string& version);
 
-bool parseHeader(const char* line, std::string& name, std::string& value);
+bool parseRespStartLine(const char* line, size_t len, std::string& version,
+                        int& code, std::string& reason);
+
+bool parseHeader(const char* line, size_t len, std::string& name,
+                 std::string& value);
 
 }  // namespace protocol
 }  // namespace http
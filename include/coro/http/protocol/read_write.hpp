@@ -1,6 +1,8 @@
 #ifndef CORO_INCLUDE_CORO_HTTP_PROTOCOL_READ_WRITE_HPP_
 #define CORO_INCLUDE_CORO_HTTP_PROTOCOL_READ_WRITE_HPP_
 
+#include <boost/utility/string_view.hpp>
+
 #include "coro/promise.hpp"
 #include "coro/stream.hpp"
 #include "request.hpp"
@@ -10,11 +12,16 @@ namespace coro {
 namespace http {
 namespace protocol {
 
+// 写入函数的 body 为正文，与起始行和标头用一次 writev 写入，
+// 在 Promise 敲定之前必须保持有效。
+
 Promise<Request> readReq(Stream stream, size_t line_len_limit = 4096);
-Promise<void> writeReq(Stream stream, const Request& req);
+Promise<void> writeReq(Stream stream, const Request& req,
+                       boost::string_view body = boost::string_view());
 
 Promise<Response> readResp(Stream stream, size_t line_len_limit = 4096);
-Promise<void> writeResp(Stream stream, const Response& resp);
+Promise<void> writeResp(Stream stream, const Response& resp,
+                        boost::string_view body = boost::string_view());
 
 }  // namespace protocol
 }  // namespace http
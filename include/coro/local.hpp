@@ -0,0 +1,79 @@
+#ifndef CORO_INCLUDE_CORO_LOCAL_HPP_
+#define CORO_INCLUDE_CORO_LOCAL_HPP_
+
+#include <cstddef>
+#include <utility>
+
+#include "sched/coro.hpp"
+#include "sched/sched.hpp"
+
+namespace coro {
+
+/**
+ * @brief 协程局部存储。同一线程中的多个协程共享 thread_local 变量，
+ * 而 CoroLocal 为每个协程保存一份独立的值，可用于沿调用栈传递请求 ID、
+ * 截止时间等上下文。
+ * 值保存在 Coro 对象中下标固定的槽位内，在协程第一次访问时构造，
+ * 在协程退出时析构。每个 CoroLocal 对象占用一个永不回收的槽位，
+ * 因此 CoroLocal 应当被定义为全局或静态变量。
+ * @tparam T 值的类型。
+ */
+template <typename T>
+class CoroLocal {
+ public:
+  CoroLocal() : index_(sched::Coro::allocLocalIndex()) {}
+
+  // CoroLocal 对象禁止拷贝和移动。
+  CoroLocal(const CoroLocal&) = delete;
+  CoroLocal& operator=(const CoroLocal&) = delete;
+  CoroLocal(CoroLocal&&) = delete;
+  CoroLocal& operator=(CoroLocal&&) = delete;
+
+  /**
+   * @brief 获取当前协程的值，如果尚未设置则默认构造一个。
+   * @return T& 当前协程的值。
+   */
+  T& get() const {
+    sched::Coro* coro = sched::currentPtr();
+    void* value = coro->local(index_);
+    if (!value) {
+      value = new T();
+      coro->setLocal(index_, value, destroy);
+    }
+    return *static_cast<T*>(value);
+  }
+
+  T& operator*() const { return get(); }
+  T* operator->() const { return &get(); }
+
+  /**
+   * @brief 设置当前协程的值。
+   * @param value 新的值。
+   */
+  void set(T value) const {
+    sched::currentPtr()->setLocal(index_, new T(std::move(value)), destroy);
+  }
+
+  /**
+   * @brief 判断当前协程是否已经设置了值。
+   * @return true 已设置。
+   * @return false 未设置。
+   */
+  bool has() const { return sched::currentPtr()->local(index_) != nullptr; }
+
+  /**
+   * @brief 析构当前协程的值。
+   */
+  void reset() const {
+    sched::currentPtr()->setLocal(index_, nullptr, nullptr);
+  }
+
+ private:
+  static void destroy(void* value) { delete static_cast<T*>(value); }
+
+  size_t index_;  // 槽位下标。
+};
+
+}  // namespace coro
+
+#endif  // CORO_INCLUDE_CORO_LOCAL_HPP_
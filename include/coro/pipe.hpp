@@ -0,0 +1,91 @@
+#ifndef CORO_INCLUDE_CORO_PIPE_HPP_
+#define CORO_INCLUDE_CORO_PIPE_HPP_
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+#include "promise.hpp"
+#include "stream.hpp"
+
+namespace coro {
+
+// 管道每个方向的环形缓冲区的默认容量，单位字节。
+static constexpr size_t kDefaultPipeCapacity = 64 * 1024;
+
+namespace impl {
+
+struct PipeState;
+
+/**
+ * @brief 内存中的全双工管道的一端，由 pipe() 成对创建。
+ * 一端写入的数据可以从另一端读取，两个方向各有一个环形缓冲区。
+ * 读取时如果没有数据，当前协程会阻塞直至对端写入或关闭；
+ * 写入时如果缓冲区已满，当前协程会阻塞直至对端读取。
+ * 管道的两端必须在同一个线程中使用。
+ */
+class PipeStream : public Stream {
+ public:
+  /**
+   * @brief 构造管道的一端，应当使用 pipe() 创建管道。
+   * @param state 两端共享的状态。
+   * @param side 本端的下标，为 0 或 1。
+   */
+  PipeStream(std::shared_ptr<PipeState> state, int side)
+      : state_(std::move(state)), side_(side) {}
+
+  /**
+   * @brief 关闭本端。
+   */
+  ~PipeStream() override { close(); }
+
+  /**
+   * @brief 向对端写入 len 个字节，全部写入缓冲区或对端的读缓冲区后才会敲定。
+   * 对端已关闭时 Promise 被拒绝，错误码为 std::errc::broken_pipe。
+   * @param buf 缓冲区。
+   * @param len 缓冲区大小。
+   * @return Promise<size_t> 写入的字节数，出错时可能小于 len。
+   */
+  Promise<size_t> write(const char* buf, size_t len) override;
+
+  /**
+   * @brief 关闭本端。对端读完缓冲区中的数据后将读取到 EOF，
+   * 本端未完成的读写操作被拒绝，错误码为 std::errc::operation_canceled。
+   */
+  void close() override;
+
+  /**
+   * @brief 关闭本端的写方向，对端读完缓冲区中的数据后将读取到 EOF，
+   * 本端仍然可以读取。本端未完成的写操作被拒绝，
+   * 错误码为 std::errc::operation_canceled。
+   */
+  void shutdownWrite() override;
+
+ protected:
+  /**
+   * @brief 从管道读取最多 len 个字节。对端关闭且管道为空时返回 0。
+   * @param buf 缓冲区。
+   * @param len 缓冲区大小。
+   * @return Promise<size_t> 读取到的字节数，可能小于 len。
+   */
+  Promise<size_t> readSome(char* buf, size_t len) override;
+
+ private:
+  std::shared_ptr<PipeState> state_;  // 两端共享的状态。
+  int side_;                          // 本端的下标。
+};
+
+}  // namespace impl
+
+using PipeStream = std::shared_ptr<impl::PipeStream>;
+
+/**
+ * @brief 创建一个内存中的全双工管道，用于测试和基准测试。
+ * @param capacity 每个方向的环形缓冲区的容量，单位字节。
+ * @return std::pair<PipeStream, PipeStream> 管道的两端。
+ */
+std::pair<PipeStream, PipeStream> pipe(size_t capacity = kDefaultPipeCapacity);
+
+}  // namespace coro
+
+#endif  // CORO_INCLUDE_CORO_PIPE_HPP_
@@ -0,0 +1,50 @@
+#ifndef CORO_INCLUDE_CORO_PROBE_HPP_
+#define CORO_INCLUDE_CORO_PROBE_HPP_
+
+// USDT（用户态静态定义追踪点），provider 为 coro。
+// 定义了 CORO_USDT 且能找到 <sys/sdt.h> 时，每个追踪点编译为一条 nop 指令，
+// 并在 ELF 的 .note.stapsdt 节中记录参数的位置，可以用 perf、bpftrace
+// 等工具在运行时挂载，例如：
+//   bpftrace -e 'usdt:./server:coro:block { @[str(arg1)] = count(); }'
+// 否则追踪点被展开为空语句，参数不会被求值。
+//
+// 追踪点及其参数：
+//   coro:spawn(coro_id)                     协程被调度。
+//   coro:resume(coro_id)                    协程恢复运行，0 表示 idle 协程。
+//   coro:block(coro_id, tag)                协程被阻塞，tag 为等待的操作。
+//   coro:wakeup(coro_id)                    协程被唤醒。
+//   coro:exit(coro_id)                      协程退出。
+//   coro:tcp_read(coro_id, n, errno)        Conn::read 完成。
+//   coro:tcp_write(coro_id, n, errno)       Conn::write 完成。
+//   coro:http_read_req(coro_id, method, url)     读取到完整的 HTTP 请求头。
+//   coro:http_read_resp(coro_id, code)           读取到完整的 HTTP 响应头。
+//   coro:http_write_req(coro_id, errno)          HTTP 请求头写入完成。
+//   coro:http_write_resp(coro_id, code, errno)   HTTP 响应头写入完成。
+//   coro:redis_exec_start(coro_id)               Redis 命令开始发送。
+//   coro:redis_exec_done(coro_id, errno)         收到 Redis 命令的回复。
+// 其中 errno 为 std::error_code::value()，0 表示成功。
+
+#if defined(CORO_USDT) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define CORO_HAS_USDT 1
+#endif
+#endif
+
+#ifdef CORO_HAS_USDT
+#define CORO_PROBE1(name, a1) DTRACE_PROBE1(coro, name, a1)
+#define CORO_PROBE2(name, a1, a2) DTRACE_PROBE2(coro, name, a1, a2)
+#define CORO_PROBE3(name, a1, a2, a3) DTRACE_PROBE3(coro, name, a1, a2, a3)
+#else
+#define CORO_PROBE1(name, a1) \
+  do {                        \
+  } while (0)
+#define CORO_PROBE2(name, a1, a2) \
+  do {                            \
+  } while (0)
+#define CORO_PROBE3(name, a1, a2, a3) \
+  do {                                \
+  } while (0)
+#endif
+
+#endif  // CORO_INCLUDE_CORO_PROBE_HPP_
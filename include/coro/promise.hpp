@@ -4,6 +4,7 @@
 #include <cassert>
 #include <memory>
 
+#include "arena.hpp"
 #include "exception.hpp"
 #include "sched/promise.hpp"
 
@@ -19,8 +20,9 @@ class Promise {
  public:
   /**
    * @brief 构造一个 Promise 对象，该 Promise 对象处于待定状态。
+   * 如果当前协程启用了 Arena，Promise 的状态从 Arena 中分配。
    */
-  Promise() : promise_(std::make_shared<sched::Promise<T>>()) {}
+  Promise() : promise_(makeShared<sched::Promise<T>>()) {}
 
   /**
    * @brief 将 Promise 设置为已兑现，并将 value 设置为异步函数的执行结果。
@@ -68,6 +70,13 @@ class Promise {
    */
   T await(std::error_code* error) const;
 
+  /**
+   * @brief 判断 Promise 是否已敲定，已敲定时 await 不会阻塞。
+   * @return true 已敲定。
+   * @return false 未敲定。
+   */
+  bool settled() const { return promise_->settled(); }
+
   /**
    * @brief Promise 被兑现时调用指定回调。
    * @param callback 回调函数，value 为异步函数执行结果。
@@ -154,7 +163,7 @@ inline Promise<T>& Promise<T>::finally(std::function<void()> callback) {
 template <>
 class Promise<void> {
  public:
-  Promise() : promise_(std::make_shared<sched::Promise<void>>()) {}
+  Promise() : promise_(makeShared<sched::Promise<void>>()) {}
   void resolve() const { promise_->resolve(); }
 
   void reject(std::error_code error) const {
@@ -163,6 +172,7 @@ class Promise<void> {
 
   void await() const;
   void await(std::error_code* error) const;
+  bool settled() const { return promise_->settled(); }
 
   Promise<void>& then(std::function<void()> callback);
   Promise<void>& except(std::function<void(std::error_code error)> callback);
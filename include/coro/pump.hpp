@@ -0,0 +1,41 @@
+#ifndef CORO_INCLUDE_CORO_PUMP_HPP_
+#define CORO_INCLUDE_CORO_PUMP_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "promise.hpp"
+#include "stream.hpp"
+
+namespace coro {
+
+// pump 每个方向的缓冲区大小，单位字节。
+static constexpr size_t kDefaultPumpBufferSize = 64 * 1024;
+
+/**
+ * @brief pump 在两个方向上转发的字节数。
+ */
+struct PumpResult {
+  uint64_t a_to_b = 0;  // 从 a 转发到 b 的字节数。
+  uint64_t b_to_a = 0;  // 从 b 转发到 a 的字节数。
+};
+
+/**
+ * @brief 在两个流之间双向转发数据，直至两个方向都读取到 EOF，用于 L4 代理。
+ * 两个流都是 tcp::Conn 时用 splice 经过管道转发，数据不经过用户态；
+ * 否则每个方向使用两个缓冲区，写入一个缓冲区的同时读取另一个缓冲区。
+ * 一个方向读取到 EOF 时，在写完已读取的数据后调用另一个流的 shutdownWrite，
+ * 另一个方向继续转发（半关闭）。任一方向出错时关闭两个流。
+ * 返回的 Promise 敲定后 a 和 b 不会被关闭，由调用者关闭。
+ * @param a 一个流。
+ * @param b 另一个流。
+ * @param buffer_size 每次读取或 splice 的最大字节数。
+ * @return Promise<PumpResult> 两个方向都结束后敲定，
+ * 出错时被拒绝，值为出错前转发的字节数。
+ */
+Promise<PumpResult> pump(Stream a, Stream b,
+                         size_t buffer_size = kDefaultPumpBufferSize);
+
+}  // namespace coro
+
+#endif  // CORO_INCLUDE_CORO_PUMP_HPP_
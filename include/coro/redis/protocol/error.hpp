@@ -8,8 +8,9 @@ namespace coro {
 namespace redis {
 namespace protocol {
 
+// 错误码从 1 开始，值为 0 的 std::error_code 表示没有错误。
 enum Errc {
-  kEof,
+  kEof = 1,
   kLineTooLong,
   kBadMessage,
 };
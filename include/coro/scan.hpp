@@ -0,0 +1,66 @@
+#ifndef CORO_INCLUDE_CORO_SCAN_HPP_
+#define CORO_INCLUDE_CORO_SCAN_HPP_
+
+#include <cstddef>
+
+namespace coro {
+namespace scan {
+
+/**
+ * @brief 扫描函数使用的指令集。
+ */
+enum class Isa {
+  kScalar,  // 逐字节扫描。
+  kSse2,    // 每次比较 16 个字节。
+  kAvx2,    // 每次比较 32 个字节。
+};
+
+/**
+ * @brief 获取当前使用的指令集。第一次调用扫描函数时，
+ * 根据 CPU 支持的指令集选择最快的实现。
+ * @return Isa 当前使用的指令集。
+ */
+Isa isa();
+
+/**
+ * @brief 强制使用指定的指令集，用于测试和基准测试，不是线程安全的。
+ * @param isa 指令集。
+ * @return bool CPU 不支持该指令集时返回 false，当前使用的指令集不变。
+ */
+bool setIsa(Isa isa);
+
+/**
+ * @brief 获取指令集的名称。
+ * @param isa 指令集。
+ * @return const char* 指令集的名称。
+ */
+const char* isaName(Isa isa);
+
+/**
+ * @brief 在 [begin, end) 中查找第一个等于 chr 的字节。
+ * @return const char* 找到的字节的位置，没有找到时返回 end。
+ */
+const char* findByte(const char* begin, const char* end, char chr);
+
+/**
+ * @brief 在 [begin, end) 中查找第一个属于 set 的字节。
+ * @param set 要查找的字节的集合。
+ * @param set_len 集合的大小，不能超过 kMaxSetSize。
+ * @return const char* 找到的字节的位置，没有找到时返回 end。
+ */
+const char* findAnyOf(const char* begin, const char* end, const char* set,
+                      size_t set_len);
+
+// findAnyOf 支持的集合的最大大小。
+static constexpr size_t kMaxSetSize = 8;
+
+/**
+ * @brief 在 [begin, end) 中查找第一个 \r\n。
+ * @return const char* \r 的位置，没有找到时返回 end。
+ */
+const char* findCrlf(const char* begin, const char* end);
+
+}  // namespace scan
+}  // namespace coro
+
+#endif  // CORO_INCLUDE_CORO_SCAN_HPP_
@@ -10,6 +10,22 @@ namespace coro {
  */
 inline static void yield() { sched::yield(); }
 
+/**
+ * @brief 如果当前协程的时间片已经超时，则让出协程。
+ * 长时间不等待 IO 的循环应当定期调用此函数，参见 sched::startWatchdog。
+ */
+inline static void checkpoint() { sched::checkpoint(); }
+
+/**
+ * @brief 追踪开启时，为当前协程记录一个用户自定义事件。
+ * @param tag 事件名，必须是静态字符串。
+ */
+inline static void trace(const char* tag) {
+  if (sched::traceEnabled()) {
+    sched::trace(sched::TraceEvent::kUser, sched::currentPtr()->id(), tag);
+  }
+}
+
 }  // namespace coro
 
 #endif  // CORO_INCLUDE_CORO_SCHED_HPP_
@@ -0,0 +1,99 @@
+#ifndef CORO_INCLUDE_CORO_SCHED_ARENA_HPP_
+#define CORO_INCLUDE_CORO_SCHED_ARENA_HPP_
+
+#include <cstddef>
+#include <vector>
+
+namespace coro {
+namespace sched {
+
+// Arena 内存块的默认大小，单位字节。
+static constexpr size_t kDefaultArenaBlockSize = 16 * 1024;
+// Arena 最多持有的内存块数。
+static constexpr size_t kDefaultArenaMaxBlocks = 8;
+
+/**
+ * @brief 基于指针碰撞（bump-pointer）的内存分配器，挂在 Coro 对象上，
+ * 用于分配协程中大量短生命周期的小对象。
+ * Arena 记录尚未释放的分配数，当所有分配都被释放时回退到第一个内存块，
+ * 已分配的内存块会被复用。只要有一个分配长期存活，Arena 就不会回退，
+ * 因此内存块数有上限，达到上限后改用 operator new 分配。
+ * Arena 只能在其所属的线程中使用。
+ */
+class Arena {
+ public:
+  /**
+   * @brief 构造一个 Arena 对象，内存块在第一次分配时才分配。
+   * @param block_size 内存块大小。
+   * @param max_blocks 最多持有的内存块数。
+   */
+  explicit Arena(size_t block_size = kDefaultArenaBlockSize,
+                 size_t max_blocks = kDefaultArenaMaxBlocks)
+      : block_size_(block_size), max_blocks_(max_blocks) {}
+
+  // Arena 对象禁止拷贝和移动，所有的 Arena 对象都由 std::shared_ptr 持有。
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+  Arena(Arena&&) = delete;
+  Arena& operator=(Arena&&) = delete;
+
+  /**
+   * @brief 释放所有内存块。
+   */
+  ~Arena();
+
+  /**
+   * @brief 分配 size 个字节。
+   * @param size 字节数。
+   * @param align 对齐要求，必须是 2 的幂。
+   * @return void* 分配到的内存。
+   */
+  void* allocate(size_t size, size_t align);
+
+  /**
+   * @brief 释放一次分配。内存块中的内存不会被立即回收，
+   * 直到所有分配都被释放时 Arena 才会回退到第一个内存块；
+   * 超出上限后由 operator new 分配的内存被立即释放。
+   * @param ptr 由 allocate 分配的内存。
+   */
+  void deallocate(void* ptr);
+
+  /**
+   * @brief 获取尚未释放的分配数，包括超出上限后由 operator new 分配的。
+   * @return size_t 尚未释放的分配数。
+   */
+  size_t live() const { return live_ + fallback_live_; }
+
+  /**
+   * @brief 获取 Arena 持有的内存块的总大小。
+   * @return size_t 内存块的总大小，单位字节。
+   */
+  size_t capacity() const;
+
+ private:
+  /**
+   * @brief 内存块。
+   */
+  struct Block {
+    char* data;
+    size_t size;
+  };
+
+  /**
+   * @brief 判断 ptr 是否位于 Arena 的内存块中。
+   */
+  bool owns(const void* ptr) const;
+
+  std::vector<Block> blocks_;  // 已分配的内存块。
+  size_t block_index_ = 0;     // 当前使用的内存块的下标。
+  size_t offset_ = 0;          // 当前内存块中第一个空闲字节的偏移量。
+  size_t live_ = 0;            // 内存块中尚未释放的分配数。
+  size_t fallback_live_ = 0;   // 由 operator new 分配且尚未释放的分配数。
+  size_t block_size_;          // 内存块大小。
+  size_t max_blocks_;          // 最多持有的内存块数。
+};
+
+}  // namespace sched
+}  // namespace coro
+
+#endif  // CORO_INCLUDE_CORO_SCHED_ARENA_HPP_
@@ -2,18 +2,67 @@
 #define CORO_INCLUDE_CORO_SCHED_CORO_HPP_
 
 #include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <memory>
+#include <vector>
 
+#include "arena.hpp"
 #include "fctx.hpp"
 
 namespace coro {
 namespace sched {
 
+/**
+ * @brief 协程的状态。
+ */
+enum class CoroState : uint8_t {
+  kReady,    // 就绪，在就绪队列中等待调度。
+  kRunning,  // 正在运行。
+  kBlocked,  // 阻塞，等待 Promise 敲定。
+  kDead,     // 已退出。
+};
+
+/**
+ * @brief 侵入式双向循环链表的节点，Scheduler 用它记录所有存活的协程。
+ */
+struct CoroLink {
+  CoroLink* prev = nullptr;
+  CoroLink* next = nullptr;
+
+  /**
+   * @brief 判断节点是否在链表中。
+   */
+  bool linked() const { return next != nullptr; }
+
+  /**
+   * @brief 将节点插入到 head 之前，即链表的末尾。
+   * @param head 链表头节点。
+   */
+  void linkBefore(CoroLink* head) {
+    prev = head->prev;
+    next = head;
+    head->prev->next = this;
+    head->prev = this;
+  }
+
+  /**
+   * @brief 将节点从链表中移除（如果在链表中）。
+   */
+  void unlink() {
+    if (linked()) {
+      prev->next = next;
+      next->prev = prev;
+      prev = next = nullptr;
+    }
+  }
+};
+
 /**
  * @brief Coro 表示一个协程对象，它在一个由 allocStack 分配的栈空间内运行
  * Coro::Func 类型的函数。
  */
-class Coro {
+class Coro : private CoroLink {
  public:
   /**
    * @brief 协程函数类型。协程函数禁止抛出异常。
@@ -50,7 +99,96 @@ class Coro {
    */
   void resume(Coro* prev) const;
 
+  /**
+   * @brief 获取协程的 ID，ID 在进程内唯一且从 1 开始递增。
+   * @return uint64_t 协程的 ID。
+   */
+  uint64_t id() const { return id_; }
+
+  /**
+   * @brief 分配一个新的协程局部存储槽位下标，所有协程共享同一套下标。
+   * @return size_t 槽位下标。
+   */
+  static size_t allocLocalIndex();
+
+  /**
+   * @brief 获取协程局部存储槽位中的值。
+   * @param index 由 allocLocalIndex 分配的槽位下标。
+   * @return void* 槽位中的值，未设置时返回 nullptr。
+   */
+  void* local(size_t index) const {
+    return index < locals_.size() ? locals_[index].value : nullptr;
+  }
+
+  /**
+   * @brief 设置协程局部存储槽位中的值，槽位中原有的值会被析构。
+   * @param index 由 allocLocalIndex 分配的槽位下标。
+   * @param value 新的值，为 nullptr 表示清空槽位。
+   * @param deleter 析构 value 的函数，在协程退出或槽位被覆盖时调用。
+   */
+  void setLocal(size_t index, void* value, void (*deleter)(void*));
+
+  /**
+   * @brief 析构所有协程局部存储槽位中的值。
+   */
+  void clearLocals();
+
+  /**
+   * @brief 获取协程的 Arena。
+   * @return const std::shared_ptr<Arena>& 协程的 Arena，未启用时为 nullptr。
+   */
+  const std::shared_ptr<Arena>& arena() const { return arena_; }
+
+  /**
+   * @brief 设置协程的 Arena。协程退出时会放弃对 Arena 的引用，
+   * Arena 在最后一个由它分配的对象被释放后析构。
+   * @param arena Arena 对象，为 nullptr 表示不使用 Arena。
+   */
+  void setArena(std::shared_ptr<Arena> arena) { arena_ = std::move(arena); }
+
+  /**
+   * @brief 获取协程的状态。
+   * @return CoroState 协程的状态。
+   */
+  CoroState state() const { return state_; }
+
+  /**
+   * @brief 获取创建协程的位置，通常是协程函数的类型名（未解码）。
+   * @return const char* 创建协程的位置，未知时为 nullptr。
+   */
+  const char* spawnSite() const { return spawn_site_; }
+
+  /**
+   * @brief 设置创建协程的位置。
+   * @param site 创建协程的位置，必须是静态字符串。
+   */
+  void setSpawnSite(const char* site) { spawn_site_ = site; }
+
+  /**
+   * @brief 获取协程最近一次阻塞时等待的操作。
+   * @return const char* 等待的操作，未知时为 nullptr。
+   */
+  const char* blockedOn() const { return blocked_on_; }
+
+  /**
+   * @brief 标记协程接下来将要等待的操作，在协程下一次阻塞时生效。
+   * IO 操作在发起时调用此函数，协程转储时可以据此找出卡住的协程。
+   * 操作同步完成（await 时已敲定）或协程让出 CPU 后标记被清除。
+   * @param tag 操作名，必须是静态字符串。
+   */
+  void setWaitTag(const char* tag) { wait_tag_ = tag; }
+
  private:
+  friend class Scheduler;
+
+  /**
+   * @brief 协程局部存储的槽位。
+   */
+  struct LocalSlot {
+    void* value = nullptr;
+    void (*deleter)(void*) = nullptr;
+  };
+
   /**
    * @brief 协程函数的包装器，该函数将调用实际的协程函数。
    * 由于协程函数禁止抛出异常，所以该函数在捕获到异常时数据错误信息并退出程序。
@@ -58,6 +196,13 @@ class Coro {
    */
   static void funcWrapper(transfer_t trans);
 
+  /**
+   * @brief 分配一个新的协程 ID。
+   * @return uint64_t 协程 ID。
+   */
+  static uint64_t nextId();
+
+  uint64_t id_ = nextId();     // 协程 ID。
   Func func_;                  // 协程函数。
   fcontext_t fctx_ = nullptr;  // fcontext 上下文。
   // 指向栈底的指针。等于 nullptr 则表示未为该协程分配栈。
@@ -65,6 +210,20 @@ class Coro {
   // 每个线程在启动时被认为是只有一个协程的线程。
   void* stack_ = nullptr;
   size_t stack_size_ = 0;  // 栈大小。
+  // 协程局部存储，在第一次设置槽位时才分配内存。
+  std::vector<LocalSlot> locals_;
+  std::shared_ptr<Arena> arena_;  // 协程的 Arena，为 nullptr 表示未启用。
+  // 协程被唤醒的时间（steady_clock，单位纳秒），为 0 表示未被唤醒。
+  // 由 Scheduler 维护，用于统计唤醒延迟。
+  int64_t wakeup_time_ = 0;
+
+  // 以下成员由 Scheduler 维护，用于转储存活的协程。
+  CoroState state_ = CoroState::kReady;  // 协程的状态。
+  const char* spawn_site_ = nullptr;     // 创建协程的位置。
+  const char* wait_tag_ = nullptr;       // 下一次阻塞时等待的操作。
+  const char* blocked_on_ = nullptr;     // 最近一次阻塞时等待的操作。
+  int64_t create_time_ = 0;  // 协程被调度的时间（steady_clock，纳秒）。
+  int64_t resume_time_ = 0;  // 协程最近一次恢复运行的时间，0 表示从未运行。
 };
 
 }  // namespace sched
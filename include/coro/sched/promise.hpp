@@ -141,6 +141,8 @@ inline void Promise<T>::reject(T value, std::error_code error) {
 template <typename T>
 inline T Promise<T>::await(std::error_code& error) {
   if (settled()) {
+    // 操作已同步完成，发起时设置的等待标记不再有效。
+    setWaitTag(nullptr);
     error = std::move(error_);
     return std::move(value_);
   }
@@ -245,6 +247,7 @@ inline void Promise<void>::reject(std::error_code error) {
 
 inline void Promise<void>::await(std::error_code& error) {
   if (settled()) {
+    setWaitTag(nullptr);
     error = std::move(error_);
     return;
   }
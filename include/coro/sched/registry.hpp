@@ -0,0 +1,59 @@
+#ifndef CORO_INCLUDE_CORO_SCHED_REGISTRY_HPP_
+#define CORO_INCLUDE_CORO_SCHED_REGISTRY_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "coro.hpp"
+
+namespace coro {
+namespace sched {
+
+/**
+ * @brief 一个存活协程的快照。
+ */
+struct CoroInfo {
+  uint64_t id;                            // 协程的 ID。
+  CoroState state;                        // 协程的状态。
+  const char* spawn_site;                 // 创建协程的位置，可能为 nullptr。
+  const char* blocked_on;                 // 阻塞时等待的操作，可能为 nullptr。
+  std::chrono::nanoseconds age;           // 协程被调度至今的时长。
+  std::chrono::nanoseconds since_resume;  // 最近一次恢复运行至今的时长。
+  std::vector<void*> backtrace;           // 挂起的协程的调用栈，可能为空。
+};
+
+/**
+ * @brief 获取协程状态的名称。
+ * @param state 协程的状态。
+ * @return const char* 状态名称。
+ */
+const char* stateName(CoroState state);
+
+/**
+ * @brief 沿帧指针回溯挂起的协程的调用栈，仅支持 x86_64。
+ * 回溯过程不会访问 [stack_lo, stack_hi) 之外的内存，
+ * 在没有帧指针（-fomit-frame-pointer）的代码中得到的调用栈可能不完整。
+ * @param fctx 协程挂起时由 jump_fcontext 保存的上下文。
+ * @param stack_lo 栈的最低地址。
+ * @param stack_hi 栈的最高地址。
+ * @param max_depth 最大深度。
+ * @return std::vector<void*> 调用栈中的返回地址。
+ */
+std::vector<void*> unwindStack(fcontext_t fctx, const void* stack_lo,
+                               const void* stack_hi, size_t max_depth);
+
+/**
+ * @brief 将协程快照以可读的文本格式输出，先输出按状态和等待的操作分组的汇总，
+ * 再逐个输出每个协程。
+ * @param out 输出流。
+ * @param coros 协程快照。
+ */
+void writeCoroDump(std::ostream& out, const std::vector<CoroInfo>& coros);
+
+}  // namespace sched
+}  // namespace coro
+
+#endif  // CORO_INCLUDE_CORO_SCHED_REGISTRY_HPP_
@@ -1,10 +1,21 @@
 #ifndef CORO_INCLUDE_CORO_SCHED_SCHED_HPP_
 #define CORO_INCLUDE_CORO_SCHED_SCHED_HPP_
 
+#include <signal.h>
+
 #include <boost/asio.hpp>
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <ostream>
+#include <vector>
 
+#include "../buffer_pool.hpp"
 #include "coro.hpp"
+#include "registry.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
+#include "watchdog.hpp"
 
 namespace coro {
 namespace sched {
@@ -15,12 +26,24 @@ namespace sched {
  */
 boost::asio::io_context& io_context();
 
+/**
+ * @brief 获取 Asio 使用的 IO 后端的名称，后端由 Asio 在编译时选择。
+ * @return const char* 后端的名称，例如 "epoll"、"io_uring" 或 "kqueue"。
+ */
+const char* ioBackend();
+
 /**
  * @brief 获取当前线程正在运行的协程对象。
  * @return std::shared_ptr<Coro> 正在运行的协程对象。
  */
 std::shared_ptr<Coro> current();
 
+/**
+ * @brief 获取当前线程正在运行的协程对象的指针，不会增加引用计数。
+ * @return Coro* 正在运行的协程对象。
+ */
+Coro* currentPtr();
+
 /**
  * @brief 在当前线程中调度指定的协程。该协程将进入就绪态。
  * @param coro 协程对象。
@@ -53,6 +76,119 @@ void exit();
  */
 void freeDead();
 
+/**
+ * @brief 在当前线程的调度器下一次空闲（没有就绪的协程，即将等待 IO）时执行
+ * task，只执行一次。可用于合并同一轮调度中的多次写入。
+ * @param task 空闲任务，在 idle 协程中执行，不能阻塞。
+ */
+void runWhenIdle(std::function<void()> task);
+
+/**
+ * @brief 获取当前线程的调度器的缓冲区池。
+ * @return BufferPool& 缓冲区池。
+ */
+BufferPool& bufferPool();
+
+/**
+ * @brief 为当前线程的调度器启动看门狗。如果某个协程连续运行超过 slice
+ * 而没有让出 CPU，看门狗会采集其调用栈并调用 handler，
+ * 之后该协程调用 checkpoint() 时会让出 CPU。
+ * @param slice 时间片长度。
+ * @param handler 协程超时时在看门狗线程中调用的回调，
+ * 为空时将报告输出到标准错误。
+ */
+void startWatchdog(std::chrono::nanoseconds slice,
+                   StallHandler handler = nullptr);
+
+/**
+ * @brief 停止当前线程的调度器的看门狗（如果有）。
+ */
+void stopWatchdog();
+
+/**
+ * @brief 如果当前协程的时间片已经超时，则处理已完成的 IO 事件并让出 CPU。
+ * 时间片未超时时只有一次原子读取的开销。
+ */
+void checkpoint();
+
+/**
+ * @brief 开始测量当前线程的调度器的调度延迟，即 IO 事件和就绪的协程
+ * 等待处理的时间。测量持续到每次调用都被 stopQueueDelay() 撤销，
+ * 再次调用只修改窗口长度。
+ * @param window 窗口长度。
+ */
+void monitorQueueDelay(std::chrono::nanoseconds window);
+
+/**
+ * @brief 撤销一次 monitorQueueDelay()，所有调用都被撤销后停止测量。
+ */
+void stopQueueDelay();
+
+/**
+ * @brief 获取当前线程的调度器最近一个完整窗口内调度延迟的最小值。
+ * 最小值超过目标说明整个窗口内都在排队，而不是短暂的突发。
+ * @return std::chrono::nanoseconds 调度延迟，未开始测量时返回 0。
+ */
+std::chrono::nanoseconds queueDelay();
+
+/**
+ * @brief 获取当前线程的调度器的统计数据。
+ * @return Stats 统计数据。
+ */
+Stats stats();
+
+/**
+ * @brief 获取所有线程的调度器的统计数据之和，可以在任意线程中调用。
+ * @return Stats 统计数据。
+ */
+Stats globalStats();
+
+/**
+ * @brief 追踪开启时，向当前线程的追踪缓冲区写入一条记录。
+ * 开启和关闭追踪参见 enableTrace 和 disableTrace。
+ * @param event 事件类型。
+ * @param coro_id 事件所属协程的 ID。
+ * @param tag 可选的标签，必须是静态字符串。
+ */
+void trace(TraceEvent event, uint64_t coro_id, const char* tag = nullptr);
+
+/**
+ * @brief 标记当前协程接下来将要等待的操作，在协程下一次阻塞时生效。
+ * @param tag 操作名，必须是静态字符串。
+ */
+void setWaitTag(const char* tag);
+
+/**
+ * @brief 获取当前线程中所有存活协程的快照，idle 协程除外。
+ * @param unwind 是否沿帧指针回溯挂起的协程的调用栈。
+ * @return std::vector<CoroInfo> 协程快照。
+ */
+std::vector<CoroInfo> coros(bool unwind = false);
+
+/**
+ * @brief 将当前线程中所有存活协程的状态、创建位置、存活时长、
+ * 阻塞时等待的操作等信息以可读的文本格式输出。
+ * @param out 输出流。
+ * @param unwind 是否沿帧指针回溯挂起的协程的调用栈。
+ */
+void dumpCoros(std::ostream& out, bool unwind = false);
+
+/**
+ * @brief 当前线程收到指定信号时，将其所有存活协程的快照输出到标准错误。
+ * 每个需要转储的线程都要调用此函数。信号由 idle 协程处理，
+ * 如果某个协程一直不让出 CPU，请使用 startWatchdog。
+ * @param signo 信号，默认为 SIGUSR1。
+ * @param unwind 是否沿帧指针回溯挂起的协程的调用栈。
+ */
+void dumpCorosOnSignal(int signo = SIGUSR1, bool unwind = false);
+
+/**
+ * @brief 将所有线程的追踪记录输出为 Chrome trace event 格式的 JSON，
+ * 可以在任意线程中调用。
+ * @param out 输出流。
+ */
+void dumpTrace(std::ostream& out);
+
 }  // namespace sched
 }  // namespace coro
 
@@ -1,11 +1,21 @@
 #ifndef CORO_INCLUDE_CORO_SCHED_SCHEDULER_HPP_
 #define CORO_INCLUDE_CORO_SCHED_SCHEDULER_HPP_
 
+#include <atomic>
 #include <boost/asio.hpp>
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <ostream>
 #include <queue>
+#include <vector>
 
+#include "../buffer_pool.hpp"
 #include "coro.hpp"
+#include "registry.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
+#include "watchdog.hpp"
 
 namespace coro {
 namespace sched {
@@ -32,6 +42,7 @@ class Scheduler {
 
   boost::asio::io_context& io_context() { return io_context_; }
   std::shared_ptr<Coro> current() const { return current_; }
+  Coro* currentPtr() const { return current_.get(); }
 
   /**
    * @brief 调度指定的协程。该协程将进入就绪态。
@@ -65,7 +76,183 @@ class Scheduler {
    */
   void freeDead();
 
+  /**
+   * @brief 在调度器下一次空闲（就绪队列为空，即将等待 IO）时执行 task，
+   * 只执行一次。task 在 idle 协程中执行，不能阻塞。
+   * @param task 空闲任务。
+   */
+  void runWhenIdle(std::function<void()> task) {
+    idle_tasks_.push_back(std::move(task));
+  }
+
+  /**
+   * @brief 获取调度器的缓冲区池。
+   * @return BufferPool& 缓冲区池。
+   */
+  BufferPool& bufferPool() { return buffer_pool_; }
+
+  /**
+   * @brief 启动看门狗，已有的看门狗会被停止。
+   * @param slice 时间片长度。
+   * @param handler 协程超时时在看门狗线程中调用的回调。
+   */
+  void startWatchdog(std::chrono::nanoseconds slice, StallHandler handler);
+
+  /**
+   * @brief 停止看门狗（如果有）。
+   */
+  void stopWatchdog();
+
+  /**
+   * @brief 开始测量调度延迟，已经在测量时只修改窗口长度。
+   * 每个窗口内定期启动探测定时器，定时器的回调比到期时间晚执行的时间即
+   * 调度延迟，包括在它之前等待处理的 IO 事件和就绪的协程。
+   * 每次调用都应当有一次对应的 stopQueueDelay()。
+   * @param window 窗口长度，每个窗口内探测 kQueueDelayProbes 次。
+   */
+  void monitorQueueDelay(std::chrono::nanoseconds window);
+
+  /**
+   * @brief 撤销一次 monitorQueueDelay()，所有调用都被撤销后停止探测定时器，
+   * 调度延迟归零。
+   */
+  void stopQueueDelay();
+
+  /**
+   * @brief 如果当前协程的时间片已经超时，则处理已完成的 IO 事件并让出 CPU。
+   */
+  void checkpoint() {
+    if (slice_expired_.load(std::memory_order_relaxed)) {
+      preempt();
+    }
+  }
+
+  /**
+   * @brief 追踪开启时，向调度器的追踪缓冲区写入一条记录。
+   * @param event 事件类型。
+   * @param coro_id 事件所属协程的 ID。
+   * @param tag 可选的标签，必须是静态字符串。
+   */
+  void trace(TraceEvent event, uint64_t coro_id, const char* tag = nullptr) {
+    if (traceEnabled()) {
+      traceBuffer()->record(event, coro_id, tag);
+    }
+  }
+
+  /**
+   * @brief 获取调度器中所有存活协程的快照，idle 协程除外。
+   * 第一次调用之前调度器只在协程被唤醒时记录恢复时间，因此第一次快照中的
+   * since_resume 可能偏大，之后的快照是准确的。
+   * @param unwind 是否回溯挂起的协程的调用栈。
+   * @return std::vector<CoroInfo> 协程快照，按调度的先后排列。
+   */
+  std::vector<CoroInfo> coros(bool unwind) const;
+
+  /**
+   * @brief 收到指定信号时将所有存活协程的快照输出到标准错误。
+   * 信号由 idle 协程处理，所以只有调度器空闲时才会输出。
+   * @param signo 信号。
+   * @param unwind 是否回溯挂起的协程的调用栈。
+   */
+  void dumpCorosOnSignal(int signo, bool unwind);
+
+  // 以下函数可以在其他线程中调用。
+
+  /**
+   * @brief 获取调度器的统计数据。
+   * @return Stats 统计数据。
+   */
+  Stats stats() const;
+
+  /**
+   * @brief 获取所有线程的调度器的统计数据之和。
+   * @return Stats 统计数据。
+   */
+  static Stats globalStats();
+
+  /**
+   * @brief 将所有线程的调度器的追踪记录输出为 Chrome trace event 格式的 JSON。
+   * @param out 输出流。
+   */
+  static void dumpTrace(std::ostream& out);
+
+  /**
+   * @brief 获取最近一个完整窗口内调度延迟的最小值（CoDel 的判定方法），
+   * 只有持续整个窗口的排队才会使它升高，短暂的突发不会。
+   * @return std::chrono::nanoseconds 调度延迟，未开始测量时返回 0。
+   */
+  std::chrono::nanoseconds queueDelay() const {
+    return std::chrono::nanoseconds(
+        queue_delay_ns_.load(std::memory_order_relaxed));
+  }
+
+  /**
+   * @brief 获取上下文切换的次数。
+   * @return uint64_t 上下文切换的次数。
+   */
+  uint64_t switches() const {
+    return switches_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief 获取正在运行的协程的 ID。
+   * @return uint64_t 正在运行的协程的 ID，idle 协程正在运行时返回 0。
+   */
+  uint64_t runningId() const {
+    return running_id_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief 将当前协程的时间片标记为已超时。
+   */
+  void expireSlice() { slice_expired_.store(true, std::memory_order_relaxed); }
+
+  /**
+   * @brief 清除当前协程的时间片超时标记。
+   */
+  void clearSlice() { slice_expired_.store(false, std::memory_order_relaxed); }
+
  private:
+  /**
+   * @brief 切换到指定的协程，所有的上下文切换都经过此函数。
+   * @param next 将要运行的协程。
+   */
+  void switchTo(std::shared_ptr<Coro> next);
+
+  /**
+   * @brief 将协程加入就绪队列。
+   * @param coro 协程对象。
+   */
+  void pushReady(std::shared_ptr<Coro> coro);
+
+  /**
+   * @brief 从就绪队列中取出队首的协程。就绪队列必须非空。
+   * @return std::shared_ptr<Coro> 协程对象。
+   */
+  std::shared_ptr<Coro> popReady();
+
+  /**
+   * @brief 获取调度器的追踪缓冲区，如果不存在则创建。
+   * @return TraceBuffer* 追踪缓冲区。
+   */
+  TraceBuffer* traceBuffer();
+
+  /**
+   * @brief 时间片超时后被 checkpoint 调用。
+   */
+  void preempt();
+
+  /**
+   * @brief 启动下一次调度延迟探测。
+   */
+  void probeQueueDelay();
+
+  /**
+   * @brief 记录一次探测得到的调度延迟，窗口结束时更新 queue_delay_ns_。
+   * @param delay 调度延迟，单位纳秒。
+   */
+  void recordQueueDelay(int64_t delay);
+
   /**
    * @brief idle 协程执行的函数。
    *
@@ -79,7 +266,43 @@ class Scheduler {
   std::shared_ptr<Coro> dead_;
   // 就绪协程队列，按先进先出的顺序被调度。
   std::queue<std::shared_ptr<Coro>> ready_queue_;
-  size_t blocked_count_ = 0;  // 处于阻塞状态的协程数量。
+  // 空闲任务，在 idle 协程等待 IO 之前执行。
+  std::vector<std::function<void()>> idle_tasks_;
+  // 缓冲区池，流的读缓冲区和协议层的临时缓冲区从这里借用。
+  BufferPool buffer_pool_;
+
+  // 统计数据。只有调度器所在的线程会修改，其他线程可以随时读取。
+  std::atomic<uint64_t> ready_count_{0};    // 就绪队列的长度。
+  std::atomic<uint64_t> blocked_count_{0};  // 处于阻塞状态的协程数量。
+  // 上下文切换的次数，看门狗也通过它判断协程是否长时间未让出 CPU。
+  std::atomic<uint64_t> switches_{0};
+  std::atomic<uint64_t> spawns_{0};   // 被调度的新协程的数量。
+  std::atomic<uint64_t> exits_{0};    // 退出的协程的数量。
+  std::atomic<uint64_t> idle_ns_{0};  // 在 io_context::run_one() 中的时间。
+  std::atomic<uint64_t> wakeup_latency_[kLatencyBuckets];  // 唤醒延迟直方图。
+  // 最近一个完整窗口内调度延迟的最小值，单位纳秒。
+  std::atomic<int64_t> queue_delay_ns_{0};
+  size_t delay_monitors_ = 0;       // 尚未撤销的 monitorQueueDelay 调用次数。
+  int64_t delay_window_ns_ = 0;     // 调度延迟的窗口长度。
+  uint64_t delay_probe_epoch_ = 0;  // 探测定时器停止的次数。
+  int64_t delay_window_start_ = 0;  // 当前窗口的开始时间。
+  int64_t delay_window_min_ = 0;    // 当前窗口内调度延迟的最小值。
+
+  // 是否在每次切换时记录恢复时间。第一次获取协程快照之前只在协程被唤醒和
+  // 第一次运行时记录，避免每次切换都读取时钟。
+  mutable bool track_resume_time_ = false;
+  std::atomic<uint64_t> running_id_{0};  // 正在运行的协程的 ID。
+  std::atomic<bool> slice_expired_{false};  // 当前协程的时间片是否已超时。
+  // 追踪缓冲区，在第一次写入时创建，其他线程可以读取。
+  std::atomic<TraceBuffer*> trace_buffer_{nullptr};
+  // 所有存活协程组成的侵入式链表的头节点，idle 协程不在链表中。
+  CoroLink live_;
+  // 触发协程转储的信号，必须在 io_context_ 之前析构。
+  std::unique_ptr<boost::asio::signal_set> dump_signals_;
+  // 调度延迟的探测定时器，必须在 io_context_ 之前析构。
+  std::unique_ptr<boost::asio::steady_timer> delay_probe_;
+  // 看门狗读取调度器的成员，因此必须最先析构。
+  std::unique_ptr<Watchdog> watchdog_;
 };
 
 }  // namespace sched
@@ -0,0 +1,56 @@
+#ifndef CORO_INCLUDE_CORO_SCHED_STATS_HPP_
+#define CORO_INCLUDE_CORO_SCHED_STATS_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace coro {
+namespace sched {
+
+// 唤醒延迟直方图的桶数。第 0 个桶统计小于 2 纳秒的延迟，
+// 第 i 个桶统计 [2^i, 2^(i+1)) 纳秒的延迟，最后一个桶统计所有更大的延迟。
+static constexpr size_t kLatencyBuckets = 32;
+// 调度延迟的每个窗口内的探测次数。
+static constexpr int kQueueDelayProbes = 10;
+
+/**
+ * @brief 调度器的统计数据。
+ */
+struct Stats {
+  uint64_t switches = 0;  // 上下文切换的次数。
+  uint64_t spawns = 0;    // 被调度的新协程的数量。
+  uint64_t exits = 0;     // 退出的协程的数量。
+  uint64_t ready = 0;     // 就绪队列的长度。
+  uint64_t blocked = 0;   // 处于阻塞状态的协程数量。
+  // idle 协程在 io_context::run_one() 中花费的时间。
+  std::chrono::nanoseconds idle_time{0};
+  // 协程从被唤醒到恢复运行的延迟直方图。
+  uint64_t wakeup_latency[kLatencyBuckets] = {};
+
+  /**
+   * @brief 累加另一个调度器的统计数据。
+   * @param other 另一个调度器的统计数据。
+   * @return Stats& 累加后的统计数据。
+   */
+  Stats& operator+=(const Stats& other);
+
+  /**
+   * @brief 根据唤醒延迟直方图估算唤醒延迟的分位数。
+   * @param quantile 分位数，取值范围为 [0, 1]。
+   * @return std::chrono::nanoseconds 延迟所在的桶的上界，没有数据时返回 0。
+   */
+  std::chrono::nanoseconds wakeUpLatency(double quantile) const;
+};
+
+/**
+ * @brief 获取延迟所在的直方图桶的下标。
+ * @param ns 延迟，单位纳秒。
+ * @return size_t 桶的下标。
+ */
+size_t latencyBucket(uint64_t ns);
+
+}  // namespace sched
+}  // namespace coro
+
+#endif  // CORO_INCLUDE_CORO_SCHED_STATS_HPP_
@@ -0,0 +1,119 @@
+#ifndef CORO_INCLUDE_CORO_SCHED_TRACE_HPP_
+#define CORO_INCLUDE_CORO_SCHED_TRACE_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+namespace coro {
+namespace sched {
+
+// 每个线程的追踪环形缓冲区的默认容量（事件数）。
+static constexpr size_t kDefaultTraceCapacity = 64 * 1024;
+
+/**
+ * @brief 追踪事件的类型。
+ */
+enum class TraceEvent : uint8_t {
+  kSpawn,   // 新协程被调度。
+  kResume,  // 协程恢复运行。
+  kBlock,   // 协程被阻塞。
+  kWakeUp,  // 协程被唤醒。
+  kExit,    // 协程退出。
+  kIo,      // IO 操作完成。
+  kUser,    // 用户自定义事件。
+};
+
+/**
+ * @brief 一条追踪记录。
+ */
+struct TraceRecord {
+  int64_t time;      // steady_clock 时间，单位纳秒。
+  uint64_t coro_id;  // 事件所属协程的 ID，0 表示 idle 协程。
+  const char* tag;   // 可选的标签，必须是静态字符串。
+  TraceEvent event;  // 事件类型。
+};
+
+/**
+ * @brief 单生产者的追踪环形缓冲区，每个调度器一个。
+ * 只有调度器所在的线程写入，其他线程可以随时读取快照。
+ * 缓冲区写满后覆盖最旧的记录。
+ */
+class TraceBuffer {
+ public:
+  /**
+   * @brief 构造一个追踪缓冲区。
+   * @param capacity 容量，会被向上取整为 2 的幂。
+   * @param tid 在 Chrome trace 中显示的线程 ID。
+   */
+  TraceBuffer(size_t capacity, uint64_t tid);
+
+  uint64_t tid() const { return tid_; }
+
+  /**
+   * @brief 写入一条追踪记录。
+   */
+  void record(TraceEvent event, uint64_t coro_id, const char* tag);
+
+  /**
+   * @brief 读取缓冲区中的所有记录，按时间顺序排列。
+   * 正在被覆盖的记录会被丢弃。缓冲区已满时，最旧的记录所在的槽位即下一条
+   * 记录的写入位置，它也会被丢弃。
+   * @return std::vector<TraceRecord> 追踪记录。
+   */
+  std::vector<TraceRecord> snapshot() const;
+
+ private:
+  std::unique_ptr<TraceRecord[]> records_;  // 环形缓冲区。
+  size_t mask_;                             // 容量减一。
+  uint64_t tid_;                            // 线程 ID。
+  std::atomic<uint64_t> head_;              // 已经写入的记录总数。
+};
+
+// 追踪是否开启。
+extern std::atomic<bool> trace_enabled;
+
+/**
+ * @brief 判断追踪是否开启。
+ * @return true 已开启。
+ * @return false 未开启。
+ */
+inline bool traceEnabled() {
+  return trace_enabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief 获取新创建的追踪缓冲区的容量。
+ * @return size_t 容量。
+ */
+size_t traceCapacity();
+
+/**
+ * @brief 开启所有线程的追踪。
+ * @param capacity 之后创建的追踪缓冲区的容量。
+ */
+void enableTrace(size_t capacity = kDefaultTraceCapacity);
+
+/**
+ * @brief 关闭所有线程的追踪，已有的记录会被保留。
+ */
+void disableTrace();
+
+/**
+ * @brief 将多个线程的追踪记录输出为 Chrome trace event 格式的 JSON，
+ * 可以用 chrome://tracing 或 Perfetto 打开。
+ * @param out 输出流。
+ * @param threads 每个线程的 ID 和追踪记录。
+ */
+void writeChromeTrace(
+    std::ostream& out,
+    const std::vector<std::pair<uint64_t, std::vector<TraceRecord>>>& threads);
+
+}  // namespace sched
+}  // namespace coro
+
+#endif  // CORO_INCLUDE_CORO_SCHED_TRACE_HPP_
@@ -0,0 +1,93 @@
+#ifndef CORO_INCLUDE_CORO_SCHED_WATCHDOG_HPP_
+#define CORO_INCLUDE_CORO_SCHED_WATCHDOG_HPP_
+
+#include <pthread.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace coro {
+namespace sched {
+
+class Scheduler;
+
+/**
+ * @brief 协程连续运行超过时间片时生成的报告。
+ */
+struct StallReport {
+  uint64_t coro_id;                  // 超时协程的 ID。
+  std::chrono::nanoseconds elapsed;  // 协程已经连续运行的时长。
+  std::vector<void*> backtrace;      // 超时协程的调用栈，可能为空。
+};
+
+/**
+ * @brief 处理 StallReport 的回调，在看门狗线程中调用。
+ */
+using StallHandler = std::function<void(const StallReport& report)>;
+
+/**
+ * @brief 将 StallReport 输出到标准错误，是 StallHandler 的默认值。
+ * @param report 协程超时报告。
+ */
+void printStallReport(const StallReport& report);
+
+/**
+ * @brief 调度器的看门狗。
+ * 看门狗线程周期性地采样调度器的上下文切换计数，如果计数长时间未变化，
+ * 说明当前协程连续运行超过了时间片。看门狗会向调度器线程发送 SIGURG
+ * 以在该线程上采集调用栈，随后调用 StallHandler，并设置调度器的时间片超时标志，
+ * 协程调用 checkpoint() 时会因此让出 CPU。
+ */
+class Watchdog {
+ public:
+  /**
+   * @brief 启动看门狗线程，必须在调度器所在的线程中构造。
+   * @param scheduler 被监控的调度器。
+   * @param slice 时间片长度。
+   * @param handler 协程超时时调用的回调。
+   */
+  Watchdog(Scheduler* scheduler, std::chrono::nanoseconds slice,
+           StallHandler handler);
+
+  // 禁止拷贝和移动，Watchdog 由 std::unique_ptr 持有。
+  Watchdog(const Watchdog&) = delete;
+  Watchdog& operator=(const Watchdog&) = delete;
+  Watchdog(Watchdog&&) = delete;
+  Watchdog& operator=(Watchdog&&) = delete;
+
+  /**
+   * @brief 停止并等待看门狗线程退出。
+   */
+  ~Watchdog();
+
+ private:
+  /**
+   * @brief 看门狗线程执行的函数。
+   */
+  void run();
+
+  /**
+   * @brief 在调度器线程上采集当前协程的调用栈。
+   * @return std::vector<void*> 调用栈，采集失败时为空。
+   */
+  std::vector<void*> captureBacktrace();
+
+  Scheduler* scheduler_;            // 被监控的调度器。
+  std::chrono::nanoseconds slice_;  // 时间片长度。
+  StallHandler handler_;            // 协程超时时调用的回调。
+  pthread_t target_;                // 调度器所在的线程。
+  bool stopped_ = false;            // 看门狗是否已被停止。
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::thread thread_;  // 看门狗线程，必须最后初始化。
+};
+
+}  // namespace sched
+}  // namespace coro
+
+#endif  // CORO_INCLUDE_CORO_SCHED_WATCHDOG_HPP_
@@ -2,6 +2,7 @@
 #define CORO_INCLUDE_CORO_SPAWN_HPP_
 
 #include <type_traits>
+#include <typeinfo>
 
 #include "exception.hpp"
 #include "promise.hpp"
@@ -54,6 +55,8 @@ inline Promise<typename std::result_of<Func()>::type> spawn(
   Promise<typename std::result_of<Func()>::type> promise;
   auto coro = std::make_shared<sched::Coro>(
       [func, promise]() { coroFuncWrapper(func, promise); }, stack_size);
+  // 协程函数的类型名包含定义它的函数，转储协程时用于定位创建协程的位置。
+  coro->setSpawnSite(typeid(Func).name());
   sched::schedule(coro);
   return promise;
 }
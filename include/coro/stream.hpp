@@ -1,6 +1,9 @@
 #ifndef CORO_INCLUDE_CORO_STREAM_HPP_
 #define CORO_INCLUDE_CORO_STREAM_HPP_
 
+#include <boost/asio/buffer.hpp>
+#include <boost/utility/string_view.hpp>
+#include <cassert>
 #include <cstddef>
 #include <memory>
 #include <string>
@@ -8,20 +11,35 @@
 #include "promise.hpp"
 
 namespace coro {
+
+// 流的读缓冲区的初始大小，单位字节。
+static constexpr size_t kDefaultReadBufferSize = 16 * 1024;
+
 namespace impl {
 
+/**
+ * @brief 字节流的基类。
+ * 每个流有一个连续的读缓冲区，fill() 从底层读取数据追加到读缓冲区，
+ * peek() 返回读缓冲区中尚未消费的数据，consume() 消费数据。
+ * 解析器可以直接在读缓冲区上工作，无需将数据拷贝到自己的缓冲区。
+ * read、readn 和 readline 优先从读缓冲区中读取。
+ * 启用读缓冲区池化后，读缓冲区为空时归还给调度器的缓冲区池，
+ * 等到底层可读时再取出，等待数据的流不占用读缓冲区。
+ * 子类需要实现 readSome、write 和 close。
+ */
 class Stream {
  public:
   Stream() = default;
   virtual ~Stream() = default;
 
   /**
-   * @brief 读取最多 len 个字节。
+   * @brief 读取最多 len 个字节。读缓冲区非空时从读缓冲区中读取，
+   * 否则直接读入 buf，不经过读缓冲区。
    * @param buf 缓冲区。
    * @param len 缓冲区大小。
    * @return Promise<size_t> 读取到的字节数，可能小于 len。
    */
-  virtual Promise<size_t> read(char* buf, size_t len) = 0;
+  Promise<size_t> read(char* buf, size_t len);
 
   /**
    * @brief 尽可能读取 len 个字节，除非读取到 EOF 或读取出错。
@@ -39,6 +57,26 @@ class Stream {
    */
   Promise<size_t> readline(char* buf, size_t len);
 
+  /**
+   * @brief 读取直至遇到 delim，数据保留在读缓冲区中，不拷贝到调用者的缓冲区。
+   * 每次填充读缓冲区后只扫描新读取的字节。返回的数据已被消费，
+   * 视图在下一次调用 fill、consume 或读取函数之前有效。
+   * @param delim 分隔符。
+   * @param max 最多读取的字节数，读取 max 个字节仍未遇到 delim 时返回这些字节。
+   * @return Promise<boost::string_view> 以 delim 结尾的数据，
+   * 读取到 EOF 时返回剩余的数据，可能为空。
+   */
+  Promise<boost::string_view> readUntil(char delim, size_t max);
+
+  /**
+   * @brief 读取数据并依次填充多个缓冲区（分散读）。读缓冲区非空时从读缓冲区中读取，
+   * 否则调用 readSomev 直接读入 bufs，不经过读缓冲区。
+   * @param bufs 缓冲区数组，在 Promise 敲定之前必须保持有效。
+   * @param count 缓冲区个数。
+   * @return Promise<size_t> 读取到的总字节数，可能小于缓冲区的总大小。
+   */
+  Promise<size_t> readv(const boost::asio::mutable_buffer* bufs, size_t count);
+
   /**
    * @brief 向流中写入 len 个字节。
    * @param buf 缓冲区。
@@ -47,26 +85,168 @@ class Stream {
    */
   virtual Promise<size_t> write(const char* buf, size_t len) = 0;
 
+  /**
+   * @brief 依次写入多个缓冲区中的数据（聚集写）。默认实现逐个调用 write，
+   * 子类可以重写为一次系统调用。
+   * @param bufs 缓冲区数组，在 Promise 敲定之前必须保持有效。
+   * @param count 缓冲区个数。
+   * @return Promise<size_t> 写入的总字节数，出错时可能小于缓冲区的总大小。
+   */
+  virtual Promise<size_t> writev(const boost::asio::const_buffer* bufs,
+                                 size_t count);
+
   /**
    * @brief 关闭流。
    */
   virtual void close() = 0;
 
+  /**
+   * @brief 关闭流的写方向（半关闭）。对端读完已写入的数据后读取到 EOF，
+   * 本端仍然可以读取。默认实现关闭整个流，子类可以重写。
+   */
+  virtual void shutdownWrite() { close(); }
+
+  /**
+   * @brief 获取读缓冲区中尚未消费的数据。
+   * 返回的视图在下一次调用 fill、consume 或读取函数之前有效。
+   * @return boost::string_view 尚未消费的数据。
+   */
+  boost::string_view peek() const {
+    return boost::string_view(read_buf_.get() + read_begin_,
+                              read_end_ - read_begin_);
+  }
+
+  /**
+   * @brief 消费读缓冲区中的前 n 个字节。
+   * @param n 字节数，不能超过 peek().size()。
+   */
+  void consume(size_t n) {
+    assert(n <= read_end_ - read_begin_);
+    read_begin_ += n;
+    if (read_begin_ == read_end_) {
+      read_begin_ = read_end_ = 0;
+    }
+  }
+
+  /**
+   * @brief 从底层读取数据追加到读缓冲区。
+   * 读缓冲区尾部空间不足时，会先将未消费的数据移动到缓冲区头部，
+   * 缓冲区已满时将其扩容为原来的两倍。
+   * @return Promise<size_t> 新读取到的字节数，为 0 表示读取到 EOF。
+   */
+  Promise<size_t> fill();
+
+  /**
+   * @brief 启用或关闭读缓冲区池化。启用后 fill 发现读缓冲区为空时，
+   * 先将其归还给当前线程的调度器的缓冲区池，调用 waitReadable 等待底层可读，
+   * 然后再从池中取出缓冲区读取数据。适合大量空闲的长连接。
+   * @param pooled 是否启用。
+   */
+  void setPooledReadBuffer(bool pooled) { pooled_read_buf_ = pooled; }
+
  protected:
   /**
-   * @brief 从流缓冲区中读取至多 len 的字节。
+   * @brief 从底层读取最多 len 个字节，由子类实现，不经过读缓冲区。
    * @param buf 缓冲区。
    * @param len 缓冲区大小。
-   * @return size_t 读取到的字节数，可能小于 len。
+   * @return Promise<size_t> 读取到的字节数，可能小于 len，为 0 表示 EOF。
+   */
+  virtual Promise<size_t> readSome(char* buf, size_t len) = 0;
+
+  /**
+   * @brief 从底层读取数据并依次填充多个缓冲区，不经过读缓冲区。
+   * 默认实现只读入第一个非空的缓冲区，子类可以重写为一次系统调用。
+   * @param bufs 缓冲区数组。
+   * @param count 缓冲区个数。
+   * @return Promise<size_t> 读取到的总字节数，为 0 表示 EOF。
+   */
+  virtual Promise<size_t> readSomev(const boost::asio::mutable_buffer* bufs,
+                                    size_t count);
+
+  /**
+   * @brief 等待底层可读，即随后的 readSome 能够立即读取到数据或 EOF。
+   * 只在启用读缓冲区池化时调用。默认实现立即敲定，
+   * 子类可以重写为等待套接字的可读事件。
+   * @return Promise<void> 底层可读时敲定。
    */
-  size_t readFromBuf(char* buf, size_t len);
+  virtual Promise<void> waitReadable();
 
  private:
-  // readline 读取到的多于的字节存储在 read_buf_ 中，
-  // 子类在读取时应该先调用 readFromBuf 读取上次多读到的数据。
-  std::string read_buf_;
-  // 尚未被 readFromBuf 读取的字节的偏移量。
-  size_t read_buf_offset_ = 0;
+  /**
+   * @brief 从读缓冲区的第 *scanned 个字节开始查找 delim。
+   * @param delim 分隔符。
+   * @param max 最多查找的字节数。
+   * @param scanned 已经扫描过的字节数，返回时更新。
+   * @return size_t 以 delim 结尾的数据的长度，达到 max 时返回 max，
+   * 需要更多数据时返回 0。
+   */
+  size_t scan(char delim, size_t max, size_t* scanned) const;
+
+  /**
+   * @brief readline 的实现，不断填充读缓冲区直至找到换行符。
+   * 同步完成的读取在循环中处理，只有异步完成时才从回调重新进入。
+   * @param buf 缓冲区。
+   * @param len 缓冲区大小。
+   * @param scanned 已经扫描过的字节数。
+   * @param promise readline 返回的 Promise。
+   */
+  void readlineFromBuf(char* buf, size_t len, size_t scanned,
+                       Promise<size_t> promise);
+
+  /**
+   * @brief readUntil 的实现，不断填充读缓冲区直至找到 delim。
+   * 同步完成的读取在循环中处理，只有异步完成时才从回调重新进入。
+   * @param delim 分隔符。
+   * @param max 最多读取的字节数。
+   * @param scanned 已经扫描过的字节数。
+   * @param promise readUntil 返回的 Promise。
+   */
+  void readUntilFromBuf(char delim, size_t max, size_t scanned,
+                        Promise<boost::string_view> promise);
+
+  /**
+   * @brief 为读缓冲区准备空间，并从底层读取数据到读缓冲区的尾部。
+   * 调用者需要在 Promise 敲定后将读取到的字节数加到 read_end_ 上。
+   * @return Promise<size_t> 读取到的字节数。
+   */
+  Promise<size_t> readIntoBuf();
+
+  /**
+   * @brief 读缓冲区为空且启用了池化时 readIntoBuf 的实现。
+   * 将读缓冲区归还给缓冲区池，底层可读后再取出缓冲区并读取数据。
+   * @return Promise<size_t> 读取到的字节数。
+   */
+  Promise<size_t> readIntoPooledBuf();
+
+  /**
+   * @brief 将读缓冲区归还给缓冲区池。
+   */
+  void releaseReadBuf();
+
+  /**
+   * @brief 从读缓冲区中拷贝至多 len 个字节并消费。
+   * @param buf 缓冲区。
+   * @param len 缓冲区大小。
+   * @return size_t 拷贝的字节数。
+   */
+  size_t copyFromBuf(char* buf, size_t len);
+
+  /**
+   * @brief 消费读缓冲区中的前 n 个字节，并返回这些字节的视图。
+   * @param n 字节数，不能超过 peek().size()。
+   * @return boost::string_view 被消费的字节。
+   */
+  boost::string_view takeFromBuf(size_t n) {
+    boost::string_view data = peek().substr(0, n);
+    consume(n);
+    return data;
+  }
+
+  std::unique_ptr<char[]> read_buf_;  // 读缓冲区，第一次 fill 时分配。
+  size_t read_buf_size_ = 0;          // 读缓冲区的大小。
+  size_t read_begin_ = 0;             // 第一个未消费的字节的位置。
+  size_t read_end_ = 0;               // 最后一个有效字节之后的位置。
+  bool pooled_read_buf_ = false;      // 是否启用读缓冲区池化。
 };
 
 }  // namespace impl
@@ -3,5 +3,6 @@
 
 #include "tcp/conn.hpp"
 #include "tcp/listener.hpp"
+#include "tcp/socket_options.hpp"
 
 #endif  // CORO_INCLUDE_CORO_TCP_HPP_
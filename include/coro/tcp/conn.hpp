@@ -1,53 +1,247 @@
 #ifndef CORO_INCLUDE_CORO_TCP_CONN_HPP_
 #define CORO_INCLUDE_CORO_TCP_CONN_HPP_
 
+#include <sys/types.h>
+
 #include <boost/asio.hpp>
+#include <deque>
+#include <functional>
+#include <memory>
 
 #include "coro/promise.hpp"
 #include "coro/stream.hpp"
+#include "socket_options.hpp"
 
 namespace coro {
 namespace tcp {
 
+// 连续同步完成的读写操作的上限，达到上限后下一次操作必须走异步路径，
+// 以便其他协程有机会运行。
+static constexpr size_t kMaxInlineCompletions = 16;
+
 namespace impl {
 
 /**
  * @brief 表示 TCP 连接的类。
+ * 读写时先尝试非阻塞的 recv/send，内核缓冲区中已有数据（或有空间）时直接
+ * 返回已敲定的 Promise，await 不会阻塞；返回 EAGAIN 时才发起异步操作。
+ * sendFile 和 splice 在内核中搬运数据，不经过用户态缓冲区。
  */
-class Conn : public coro::impl::Stream {
+class Conn : public coro::impl::Stream,
+             public std::enable_shared_from_this<Conn> {
  public:
   explicit Conn(boost::asio::io_context& io_context) : socket_(io_context) {}
 
   /**
-   * @brief 读取最多 len 个字节。
-   * @param buf 缓冲区。
-   * @param len 缓冲区大小。
-   * @return Promise<size_t> 读取到的字节数，可能小于 len。
+   * @brief 关闭 splice 使用的管道（如果有）。
    */
-  Promise<size_t> read(char* buf, size_t len) override;
+  ~Conn() override;
 
   /**
-   * @brief 向流中写入 len 个字节。
+   * @brief 向流中写入 len 个字节。除非出错，所有数据都会被写入。
+   * 之前的写入尚未完成时排队，多个协程同时写入时数据按调用的顺序发送。
    * @param buf 缓冲区。
    * @param len 缓冲区大小。
    * @return Promise<size_t> 写入的字节数，出错时可能小于 len。
    */
   Promise<size_t> write(const char* buf, size_t len) override;
 
+  /**
+   * @brief 用一次 sendmsg 写入多个缓冲区中的数据，无需先拼接到一起。
+   * 除非出错，所有数据都会被写入。
+   * @param bufs 缓冲区数组，在 Promise 敲定之前必须保持有效。
+   * @param count 缓冲区个数。
+   * @return Promise<size_t> 写入的总字节数，出错时可能小于缓冲区的总大小。
+   */
+  Promise<size_t> writev(const boost::asio::const_buffer* bufs,
+                         size_t count) override;
+
+  /**
+   * @brief 用 sendfile(2) 将文件中的数据发送到连接，数据不经过用户态。
+   * 发送缓冲区已满时等待套接字可写后继续发送。
+   * @param fd 文件描述符，在 Promise 敲定之前必须保持打开。
+   * @param offset 文件中的起始位置，不影响 fd 的文件偏移量。
+   * @param len 发送的字节数。
+   * @return Promise<size_t> 发送的字节数，文件提前结束或出错时可能小于 len。
+   */
+  Promise<size_t> sendFile(int fd, off_t offset, size_t len);
+
+  /**
+   * @brief 用 splice(2) 经过管道将 src 中的数据转发到本连接，数据不经过用户态。
+   * 与 read 相同，src 中暂时没有数据时等待，转发了一批数据后即敲定。
+   * src 的读缓冲区中尚未消费的数据会先用 write 转发。
+   * @param src 源连接，不能是本连接。
+   * @param len 最多转发的字节数。
+   * @return Promise<size_t> 转发的字节数，为 0 表示 src 读取到 EOF。
+   */
+  Promise<size_t> splice(std::shared_ptr<Conn> src, size_t len);
+
+  /**
+   * @brief 设置套接字选项，值为 0 或 false 的选项保持不变。
+   * 连接已经建立，fast_open 被忽略。
+   * @param options 选项。
+   * @return std::error_code 第一个设置失败的选项的错误码。
+   */
+  std::error_code setOptions(const SocketOptions& options) {
+    return applySocketOptions(socket_.native_handle(), options,
+                              SocketRole::kConnected);
+  }
+
+  /**
+   * @brief 获取套接字的文件描述符，用于设置 SocketOptions 之外的选项。
+   * @return int 文件描述符，仍然由 Conn 持有。
+   */
+  int nativeHandle() { return socket_.native_handle(); }
+
   /**
    * @brief 关闭连接。
    */
   void close() override { socket_.close(); }
 
+  /**
+   * @brief 关闭连接的发送方向，对端读完已发送的数据后读取到 EOF。
+   */
+  void shutdownWrite() override {
+    boost::system::error_code error;
+    socket_.shutdown(boost::asio::ip::tcp::socket::shutdown_send, error);
+  }
+
+ protected:
+  /**
+   * @brief 从套接字读取最多 len 个字节。
+   * @param buf 缓冲区。
+   * @param len 缓冲区大小。
+   * @return Promise<size_t> 读取到的字节数，可能小于 len。
+   */
+  Promise<size_t> readSome(char* buf, size_t len) override;
+
+  /**
+   * @brief 用一次 recvmsg 从套接字读取数据并依次填充多个缓冲区。
+   * 与 readSome 相同，内核缓冲区中已有数据时同步完成。
+   * @param bufs 缓冲区数组。
+   * @param count 缓冲区个数。
+   * @return Promise<size_t> 读取到的总字节数。
+   */
+  Promise<size_t> readSomev(const boost::asio::mutable_buffer* bufs,
+                            size_t count) override;
+
+  /**
+   * @brief 等待套接字可读。内核缓冲区中已有数据时立即敲定，
+   * 否则等待可读事件，期间不占用任何缓冲区。
+   * @return Promise<void> 套接字可读时敲定。
+   */
+  Promise<void> waitReadable() override;
+
  private:
   friend class Listener;
-  friend Promise<std::shared_ptr<Conn>> connect(const std::string& host,
-                                                uint16_t port);
+  friend Promise<std::shared_ptr<Conn>> connect(
+      const std::string& host, uint16_t port, const SocketOptions& options);
+
+  /**
+   * @brief 判断本次读写能否尝试同步完成，必要时将套接字设为非阻塞模式。
+   * @return bool 连续同步完成的次数达到上限或设置失败时返回 false。
+   */
+  bool tryInline();
+
+  /**
+   * @brief 是否有尚未完成的写入，此时新的写入必须排队。
+   */
+  bool writeBusy() const { return writing_ || !write_queue_.empty(); }
+
+  /**
+   * @brief 异步写入完成时调用，按顺序开始排队的写入。
+   */
+  void finishWrite();
+
+  /**
+   * @brief write 的实现，先尝试同步写入，剩余的数据异步写入。
+   * @param buf 缓冲区。
+   * @param len 缓冲区大小。
+   * @param coro_id 调用 write 的协程的 ID。
+   * @param promise write 返回的 Promise。
+   */
+  void startWrite(const char* buf, size_t len, uint64_t coro_id,
+                  Promise<size_t> promise);
+
+  /**
+   * @brief writev 的实现，先尝试同步写入，剩余的数据异步写入。
+   * @param bufs 缓冲区数组。
+   * @param count 缓冲区个数。
+   * @param coro_id 调用 writev 的协程的 ID。
+   * @param promise writev 返回的 Promise。
+   */
+  void startWritev(const boost::asio::const_buffer* bufs, size_t count,
+                   uint64_t coro_id, Promise<size_t> promise);
+
+  /**
+   * @brief 发送文件直至发送缓冲区已满，然后等待套接字可写后继续。
+   * @param fd 文件描述符。
+   * @param offset 下一个要发送的字节在文件中的位置。
+   * @param len 剩余的字节数。
+   * @param sent 已经发送的字节数。
+   * @param coro_id 调用 sendFile 的协程的 ID。
+   * @param promise sendFile 返回的 Promise。
+   */
+  void sendFileSome(int fd, off_t offset, size_t len, size_t sent,
+                    uint64_t coro_id, Promise<size_t> promise);
+
+  /**
+   * @brief 将管道中的数据写入本连接，发送缓冲区已满时等待套接字可写后继续。
+   * @param src 源连接。
+   * @param len 最多从 src 读取的字节数。
+   * @param in_pipe 管道中尚未写入本连接的字节数。
+   * @param forwarded 已经转发的字节数。
+   * @param coro_id 调用 splice 的协程的 ID。
+   * @param promise splice 返回的 Promise。
+   */
+  void spliceToSocket(std::shared_ptr<Conn> src, size_t len, size_t in_pipe,
+                      size_t forwarded, uint64_t coro_id,
+                      Promise<size_t> promise);
+
+  /**
+   * @brief 从 src 读取一批数据到管道中，src 中暂时没有数据时等待。
+   * @param src 源连接。
+   * @param len 最多从 src 读取的字节数。
+   * @param coro_id 调用 splice 的协程的 ID。
+   * @param promise splice 返回的 Promise。
+   */
+  void spliceFromSource(std::shared_ptr<Conn> src, size_t len,
+                        uint64_t coro_id, Promise<size_t> promise);
+
+  /**
+   * @brief 关闭 splice 使用的管道，出错时管道中可能残留数据。
+   */
+  void closePipe();
 
   boost::asio::ip::tcp::socket socket_;
+  size_t inline_streak_ = 0;  // 连续同步完成的读写操作的次数。
+  int pipe_[2] = {-1, -1};    // splice 使用的管道，第一次 splice 时创建。
+  bool reading_ = false;      // 是否有未完成的异步读取。
+  bool writing_ = false;      // 是否有未完成的异步写入。
+  // 等待之前的写入完成的写入，保证数据按调用的顺序发送。
+  std::deque<std::function<void()>> write_queue_;
 };
 
-Promise<std::shared_ptr<Conn>> connect(const std::string& host, uint16_t port);
+/**
+ * @brief 按照选项连接到指定的地址和端口，选项在发起连接之前设置。
+ * @param host 地址。
+ * @param port 端口。
+ * @param options 套接字选项。
+ * @return Promise<std::shared_ptr<Conn>> 建立的连接。
+ */
+Promise<std::shared_ptr<Conn>> connect(const std::string& host, uint16_t port,
+                                       const SocketOptions& options);
+
+/**
+ * @brief 连接到指定的地址和端口。
+ * @param host 地址。
+ * @param port 端口。
+ * @return Promise<std::shared_ptr<Conn>> 建立的连接。
+ */
+inline Promise<std::shared_ptr<Conn>> connect(const std::string& host,
+                                              uint16_t port) {
+  return connect(host, port, SocketOptions());
+}
 
 }  // namespace impl
 
@@ -2,24 +2,79 @@
 #define CORO_INCLUDE_CORO_TCP_LISTENER_HPP_
 
 #include <boost/asio.hpp>
+#include <chrono>
+#include <functional>
 #include <memory>
 #include <string>
 #include <system_error>
+#include <vector>
 
 #include "conn.hpp"
 #include "coro/promise.hpp"
+#include "socket_options.hpp"
 
 namespace coro {
 namespace tcp {
+
+// serve 每次最多接受的连接数。
+static constexpr size_t kDefaultAcceptBatch = 64;
+
+/**
+ * @brief 创建 Listener 的选项。
+ */
+struct ListenOptions {
+  bool reuse_address = true;  // 设置 SO_REUSEADDR。
+  // 设置 SO_REUSEPORT。每个调度器线程各自监听同一端口，
+  // 内核将新连接分配给其中一个监听套接字，accept 不再集中在一个线程中。
+  bool reuse_port = false;
+  // 大于 0 时附加 CBPF 程序（SO_ATTACH_REUSEPORT_CBPF），按处理 SYN 的 CPU
+  // 选择 SO_REUSEPORT 组中下标为 CPU 编号 % cpu_steering_group 的监听套接字，
+  // 组中的下标即加入组的先后顺序。需要 reuse_port，并且第 i 个绑定的监听套接字
+  // 所在的线程应当运行在 CPU i 上。关闭组中的监听套接字时，内核将组中最后一个
+  // 套接字移到它的位置，此后的下标不再与绑定顺序对应；需要关闭其中一个时，
+  // 应当关闭整个组并按顺序重新绑定。
+  unsigned cpu_steering_group = 0;
+  int backlog = boost::asio::socket_base::max_listen_connections;  // 队列长度。
+  // 监听套接字的选项，在 bind 之前设置，被接受的连接继承这些选项。
+  SocketOptions socket;
+};
+
+/**
+ * @brief serve 的选项，用于在过载时保持有效吞吐量。
+ */
+struct ServeOptions {
+  size_t batch = kDefaultAcceptBatch;  // 每次最多接受的连接数。
+  // 同时处理的连接数的上限，为 0 表示不限制。达到上限时暂停接受连接，
+  // 新连接留在监听队列中，直至有 handler 返回。
+  size_t max_conns = 0;
+  // 调度延迟的目标，为 0 表示不丢弃连接。最近一个完整的 shed_interval 内
+  // 调度延迟始终超过目标时，新接受的连接被丢弃而不是交给 handler，
+  // 直至调度延迟回落到目标以下。参见 sched::queueDelay()。
+  std::chrono::nanoseconds shed_target{0};
+  std::chrono::nanoseconds shed_interval = std::chrono::milliseconds(100);
+  // 处理被丢弃的连接，例如返回 503 后关闭，在新协程中执行，应当尽快返回。
+  // 为空时直接关闭连接。
+  std::function<void(Conn)> shed_handler;
+  // 同时执行的 shed_handler 的上限，达到上限后被丢弃的连接直接关闭，
+  // 避免过载时为丢弃连接创建的协程本身拖慢调度器。
+  size_t max_shed_handlers = 64;
+};
+
 namespace impl {
 
 /**
  * @brief 表示 TCP 连接监听器的类。
  */
-class Listener {
+class Listener : public std::enable_shared_from_this<Listener> {
  public:
-  explicit Listener(boost::asio::ip::tcp::acceptor acceptor)
-      : acceptor_(std::move(acceptor)) {}
+  /**
+   * @brief 构造 Listener，应当使用 listen() 创建。
+   * @param acceptor 已经开始监听的 acceptor。
+   * @param options 被接受的连接的套接字选项。
+   */
+  explicit Listener(boost::asio::ip::tcp::acceptor acceptor,
+                    const SocketOptions& options = SocketOptions())
+      : acceptor_(std::move(acceptor)), options_(options) {}
 
   /**
    * @brief 接受一个 TCP 连接。
@@ -27,21 +82,137 @@ class Listener {
    */
   Promise<std::shared_ptr<Conn>> accept();
 
+  /**
+   * @brief 接受监听队列中所有已完成握手的连接，最多 max 个。
+   * 不断调用非阻塞的 accept4 直至返回 EAGAIN，队列为空时等待新连接到达，
+   * 因此连接风暴中每次唤醒可以接受一批连接。
+   * @param max 最多接受的连接数。
+   * @return Promise<std::vector<std::shared_ptr<Conn>>> 接受到的连接，
+   * max 不为 0 时至少一个，为 0 时立即兑现为空。
+   */
+  Promise<std::vector<std::shared_ptr<Conn>>> acceptBatch(size_t max);
+
+  /**
+   * @brief 在新协程中不断批量接受连接，并为每个连接创建一个协程执行 handler。
+   * 文件描述符或内存不足（EMFILE、ENFILE、ENOBUFS、ENOMEM）时等待一段时间
+   * 后重试，连续失败时等待时间加倍，最长 1 秒。
+   * @param handler 处理连接的函数，在新协程中执行。
+   * @param batch 每次最多接受的连接数。
+   * @return Promise<void> 监听器被关闭时敲定，接受连接出错时被拒绝。
+   */
+  Promise<void> serve(std::function<void(std::shared_ptr<Conn>)> handler,
+                      size_t batch = kDefaultAcceptBatch);
+
+  /**
+   * @brief 与 serve(handler, batch) 相同，并按照选项限制同时处理的连接数、
+   * 在过载时丢弃新连接。
+   * @param handler 处理连接的函数，在新协程中执行。
+   * @param options 选项。
+   * @return Promise<void> 监听器被关闭时敲定，接受连接出错时被拒绝。
+   */
+  Promise<void> serve(std::function<void(std::shared_ptr<Conn>)> handler,
+                      const ServeOptions& options);
+
+  /**
+   * @brief 获取 serve 中正在执行的 handler 的个数。
+   * @return size_t 正在处理的连接数。
+   */
+  size_t activeConns() const { return active_conns_; }
+
+  /**
+   * @brief 获取 serve 因过载而丢弃的连接数。
+   * @return uint64_t 累计丢弃的连接数。
+   */
+  uint64_t shedConns() const { return shed_conns_; }
+
+  /**
+   * @brief 获取监听的端口，监听端口 0 时可以由此得到系统分配的端口。
+   * @return uint16_t 端口。
+   */
+  uint16_t port() const { return acceptor_.local_endpoint().port(); }
+
+  /**
+   * @brief 停止监听，未完成的 accept 被拒绝，因连接数达到上限而暂停的 serve
+   * 结束。
+   */
+  void close();
+
  private:
+  /**
+   * @brief 用非阻塞的 accept4 接受监听队列中的连接。
+   * @param max 最多接受的连接数。
+   * @param conns 接受到的连接被追加到这里。
+   * @return std::error_code 错误码，监听队列为空时为空。
+   */
+  std::error_code acceptReady(size_t max,
+                              std::vector<std::shared_ptr<Conn>>* conns);
+
+  /**
+   * @brief acceptBatch 的实现，监听队列为空时等待可读后重试。
+   * @param max 最多接受的连接数。
+   * @param coro_id 调用 acceptBatch 的协程的 ID。
+   * @param promise acceptBatch 返回的 Promise。
+   */
+  void acceptBatchSome(size_t max, uint64_t coro_id,
+                       Promise<std::vector<std::shared_ptr<Conn>>> promise);
+
+  /**
+   * @brief serve 中的 handler 返回时调用，唤醒因连接数达到上限而暂停的 serve。
+   */
+  void releaseConn();
+
+  /**
+   * @brief 唤醒所有等待 handler 返回的 serve。
+   */
+  void wakeSlotWaiters();
+
   boost::asio::ip::tcp::acceptor acceptor_;
+  SocketOptions options_;    // 被接受的连接的套接字选项。
+  size_t active_conns_ = 0;   // 正在执行的 handler 的个数。
+  uint64_t shed_conns_ = 0;   // 累计丢弃的连接数。
+  size_t shed_handlers_ = 0;  // 正在执行的 shed_handler 的个数。
+  // 因连接数达到上限而暂停的 serve。
+  std::vector<Promise<void>> slot_waiters_;
 };
 
 /**
- * @brief 创建一个监听指定地址和端口的 Listener。
+ * @brief 按照选项创建一个监听指定地址和端口的 Listener。
  * @param host 监听的地址。
  * @param port 监听的端口。
+ * @param options 选项。
  * @param error 错误码，为 nullptr 表示忽略错误。
  * @return std::shared_ptr<impl::Listener> 若成功返回 Listener 对象，
  * 否则返回 nullptr。
  */
 std::shared_ptr<impl::Listener> listen(const std::string& host, uint16_t port,
+                                       const ListenOptions& options,
                                        std::error_code* error);
 
+/**
+ * @brief 按照选项创建一个监听指定地址和端口的 Listener。出错时抛出
+ * coro::Exception 异常。
+ * @param host 监听的地址。
+ * @param port 监听的端口。
+ * @param options 选项。
+ * @return std::shared_ptr<impl::Listener> Listener 对象。
+ */
+std::shared_ptr<impl::Listener> listen(const std::string& host, uint16_t port,
+                                       const ListenOptions& options);
+
+/**
+ * @brief 创建一个监听指定地址和端口的 Listener。
+ * @param host 监听的地址。
+ * @param port 监听的端口。
+ * @param error 错误码，为 nullptr 表示忽略错误。
+ * @return std::shared_ptr<impl::Listener> 若成功返回 Listener 对象，
+ * 否则返回 nullptr。
+ */
+inline std::shared_ptr<impl::Listener> listen(const std::string& host,
+                                              uint16_t port,
+                                              std::error_code* error) {
+  return listen(host, port, ListenOptions(), error);
+}
+
 /**
  * @brief 创建一个监听指定地址和端口的 Listener。出错时抛出 coro::Exception
  * 异常。
@@ -0,0 +1,61 @@
+#ifndef CORO_INCLUDE_CORO_TCP_SOCKET_OPTIONS_HPP_
+#define CORO_INCLUDE_CORO_TCP_SOCKET_OPTIONS_HPP_
+
+#include <system_error>
+
+namespace coro {
+namespace tcp {
+
+// 启用 TCP Fast Open 时监听套接字的 TFO 队列长度。
+static constexpr int kFastOpenQueueLength = 256;
+
+/**
+ * @brief TCP 套接字选项。值为 0 或 false 的选项保持系统默认值，不会调用
+ * setsockopt，因此默认构造的选项没有额外开销。
+ */
+struct SocketOptions {
+  bool no_delay = false;  // TCP_NODELAY，关闭 Nagle 算法。
+  // TCP_QUICKACK，立即发送 ACK 而不是延迟确认。内核之后可能恢复延迟确认，
+  // 因此只在建立连接时生效。
+  bool quick_ack = false;
+  // TCP Fast Open。监听套接字设置 TCP_FASTOPEN，connect 设置
+  // TCP_FASTOPEN_CONNECT，第一次写入的数据随 SYN 发送。
+  bool fast_open = false;
+  int send_buffer = 0;     // SO_SNDBUF，单位字节。
+  int receive_buffer = 0;  // SO_RCVBUF，单位字节。
+  int busy_poll = 0;       // SO_BUSY_POLL，读取时忙等的时间，单位微秒。
+  // TCP_NOTSENT_LOWAT，发送缓冲区中尚未发送的数据少于该值时才可写，单位字节。
+  int not_sent_lowat = 0;
+  // 大于 0 时启用 SO_KEEPALIVE，连接空闲该时间后开始发送探测，单位秒。
+  int keepalive_idle = 0;
+  int keepalive_interval = 0;  // TCP_KEEPINTVL，探测的间隔，单位秒。
+  int keepalive_count = 0;     // TCP_KEEPCNT，判定连接断开的探测次数。
+};
+
+namespace impl {
+
+/**
+ * @brief 套接字的用途，决定 fast_open 对应的选项。
+ */
+enum class SocketRole {
+  kListener,   // 监听套接字，在 bind 之前设置。
+  kConnect,    // 主动连接的套接字，在 connect 之前设置。
+  kAccepted,   // 被接受的套接字，只设置不会从监听套接字继承的选项。
+  kConnected,  // 已经建立的连接，忽略 fast_open。
+};
+
+/**
+ * @brief 为套接字设置选项。
+ * @param fd 套接字。
+ * @param options 选项。
+ * @param role 套接字的用途。
+ * @return std::error_code 第一个失败的 setsockopt 的错误码。
+ */
+std::error_code applySocketOptions(int fd, const SocketOptions& options,
+                                   SocketRole role);
+
+}  // namespace impl
+}  // namespace tcp
+}  // namespace coro
+
+#endif  // CORO_INCLUDE_CORO_TCP_SOCKET_OPTIONS_HPP_
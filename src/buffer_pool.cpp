@@ -0,0 +1,59 @@
+#include "coro/buffer_pool.hpp"
+
+#include <utility>
+
+namespace coro {
+
+BufferPool::BufferPool(size_t max_cached_bytes)
+    : max_cached_bytes_(max_cached_bytes),
+      free_(classIndex(kMaxPooledBufferSize) + 1) {}
+
+size_t BufferPool::classIndex(size_t size) {
+  size_t index = 0;
+  for (size_t capacity = kMinPooledBufferSize; capacity < size;
+       capacity *= 2) {
+    index++;
+  }
+  return index;
+}
+
+size_t BufferPool::capacityFor(size_t size) {
+  if (size > kMaxPooledBufferSize) {
+    return size;
+  }
+  return kMinPooledBufferSize << classIndex(size);
+}
+
+std::unique_ptr<char[]> BufferPool::acquire(size_t size) {
+  if (size > kMaxPooledBufferSize) {
+    stats_.oversized++;
+    return std::unique_ptr<char[]>(new char[size]);
+  }
+  std::vector<std::unique_ptr<char[]>>& list = free_[classIndex(size)];
+  if (list.empty()) {
+    stats_.misses++;
+    return std::unique_ptr<char[]>(new char[capacityFor(size)]);
+  }
+  stats_.hits++;
+  stats_.cached_buffers--;
+  stats_.cached_bytes -= capacityFor(size);
+  std::unique_ptr<char[]> buf = std::move(list.back());
+  list.pop_back();
+  return buf;
+}
+
+void BufferPool::release(std::unique_ptr<char[]> buf, size_t size) {
+  if (!buf || size > kMaxPooledBufferSize) {
+    return;
+  }
+  size_t capacity = capacityFor(size);
+  if (stats_.cached_bytes + capacity > max_cached_bytes_) {
+    stats_.drops++;
+    return;
+  }
+  stats_.cached_buffers++;
+  stats_.cached_bytes += capacity;
+  free_[classIndex(size)].push_back(std::move(buf));
+}
+
+}  // namespace coro
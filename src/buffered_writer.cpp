@@ -0,0 +1,167 @@
+#include "coro/buffered_writer.hpp"
+
+#include <cassert>
+#include <vector>
+
+#include "coro/sched/sched.hpp"
+
+namespace coro {
+namespace impl {
+
+Promise<size_t> BufferedWriter::write(const char* buf, size_t len) {
+  Promise<size_t> promise;
+  if (error_) {
+    promise.reject(0, error_);
+    return promise;
+  }
+
+  // 缓冲区已满，或者已经有阻塞的写入（保证写入的顺序）。
+  if (!blocked_writes_.empty() || !fits(len)) {
+    blocked_writes_.push_back({buf, len, promise});
+    if (!flushing_) {
+      startFlush();
+    }
+    sched::setWaitTag("buffered.write");
+    return promise;
+  }
+
+  pending_.append(buf, len);
+  appended_ += len;
+  if (!flushing_) {
+    if (pending_.size() >= threshold_) {
+      startFlush();
+    } else if (!idle_flush_scheduled_) {
+      // 等到所有协程都阻塞时再写入，以便合并本轮调度中的其他写入。
+      idle_flush_scheduled_ = true;
+      std::weak_ptr<BufferedWriter> weak = shared_from_this();
+      sched::runWhenIdle([weak]() {
+        auto self = weak.lock();
+        if (!self) {
+          return;
+        }
+        self->idle_flush_scheduled_ = false;
+        if (!self->flushing_ && !self->pending_.empty() && !self->error_) {
+          self->startFlush();
+        }
+      });
+    }
+  }
+  promise.resolve(len);
+  return promise;
+}
+
+Promise<void> BufferedWriter::flush() {
+  Promise<void> promise;
+  if (error_) {
+    promise.reject(error_);
+    return promise;
+  }
+  if (written_ == appended_) {
+    promise.resolve();
+    return promise;
+  }
+
+  flush_waiters_.push_back({appended_, promise});
+  if (!flushing_) {
+    startFlush();
+  }
+  sched::setWaitTag("buffered.flush");
+  return promise;
+}
+
+void BufferedWriter::startFlush() {
+  assert(!flushing_ && inflight_.empty());
+  flushing_ = true;
+  // 交换而不是拷贝，两个缓冲区的内存都会被重复使用。
+  inflight_.swap(pending_);
+  inflight_offset_ = 0;
+  writeInflight();
+}
+
+void BufferedWriter::writeInflight() {
+  auto self = shared_from_this();
+  stream_->write(inflight_.data() + inflight_offset_,
+                 inflight_.size() - inflight_offset_)
+      .then([self](size_t n) { self->onFlushed(n, std::error_code()); })
+      .except([self](size_t n, std::error_code error) {
+        self->onFlushed(n, std::move(error));
+      });
+}
+
+void BufferedWriter::onFlushed(size_t n, std::error_code error) {
+  written_ += n;
+  inflight_offset_ += n;
+  // 底层流只写入了部分数据，继续写入剩余的数据。
+  if (!error && inflight_offset_ < inflight_.size()) {
+    if (n > 0) {
+      writeInflight();
+      return;
+    }
+    error = std::make_error_code(std::errc::io_error);
+  }
+  flushing_ = false;
+  inflight_.clear();
+
+  // 先修改状态，再敲定 Promise，因为 Promise 的回调可能再次写入。
+  if (error) {
+    error_ = error;
+    pending_.clear();
+    std::deque<BlockedWrite> blocked_writes;
+    std::deque<FlushWaiter> flush_waiters;
+    blocked_writes.swap(blocked_writes_);
+    flush_waiters.swap(flush_waiters_);
+    for (auto& blocked : blocked_writes) {
+      blocked.promise.reject(0, error);
+    }
+    for (auto& waiter : flush_waiters) {
+      waiter.promise.reject(error);
+    }
+    return;
+  }
+
+  // 写入期间到达的数据已经等待了一次写入，立即写入底层流，
+  // 腾出的缓冲区用于接受阻塞的写入。
+  if (!pending_.empty()) {
+    startFlush();
+  }
+  // 按顺序接受阻塞的写入，直至缓冲区再次变满。
+  std::vector<BlockedWrite> accepted;
+  while (!blocked_writes_.empty() && fits(blocked_writes_.front().len)) {
+    BlockedWrite& blocked = blocked_writes_.front();
+    pending_.append(blocked.buf, blocked.len);
+    appended_ += blocked.len;
+    accepted.push_back(std::move(blocked));
+    blocked_writes_.pop_front();
+  }
+  if (!flushing_ && !pending_.empty()) {
+    startFlush();
+  }
+  std::vector<Promise<void>> flushed;
+  while (!flush_waiters_.empty() &&
+         flush_waiters_.front().target <= written_) {
+    flushed.push_back(std::move(flush_waiters_.front().promise));
+    flush_waiters_.pop_front();
+  }
+
+  for (auto& blocked : accepted) {
+    blocked.promise.resolve(blocked.len);
+  }
+  for (auto& promise : flushed) {
+    promise.resolve();
+  }
+}
+
+void BufferedWriter::shutdownWrite() {
+  auto self = shared_from_this();
+  flush().finally([self]() { self->stream_->shutdownWrite(); });
+}
+
+}  // namespace impl
+
+BufferedWriter bufferWrites(Stream stream, size_t threshold, size_t limit) {
+  assert(threshold <= limit);
+  return std::make_shared<impl::BufferedWriter>(std::move(stream), threshold,
+                                                limit);
+}
+
+}  // namespace coro
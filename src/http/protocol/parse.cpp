@@ -1,93 +1,79 @@
 #include "coro/http/protocol/parse.hpp"
 
 #include <cctype>
-#include <cstring>
+
+#include "coro/scan.hpp"
 
 namespace coro {
 namespace http {
 namespace protocol {
 
-bool parseReqStartLine(const char* line, std::string& method, std::string& url,
-                       std::string& version) {
-  const char* cursor = line;
-  method.clear();
-  url.clear();
-  version.clear();
-
-  for (; !isblank(*cursor); cursor++) {
-    if (*cursor == '\n') {
-      return false;
-    }
-    method.push_back(*cursor);
-  }
-  if (method.empty()) {
+/**
+ * @brief 读取一个以空白字符结尾的词，并跳过其后的空白字符。
+ * @param cursor 词的开头，返回时指向下一个词的开头。
+ * @param end 行尾。
+ * @param word 读取到的词。
+ * @return bool 词为空或在词中遇到 \n 时返回 false。
+ */
+static bool parseWord(const char*& cursor, const char* end,
+                      std::string& word) {
+  static const char kStops[] = {' ', '\t', '\n'};
+  const char* stop = scan::findAnyOf(cursor, end, kStops, sizeof(kStops));
+  if (stop == end || *stop == '\n' || stop == cursor) {
     return false;
   }
-  cursor++;
-  for (; isblank(*cursor); cursor++) {
-    if (*cursor == '\n') {
-      return false;
-    }
+  word.assign(cursor, stop);
+  cursor = stop + 1;
+  for (; cursor < end && isblank(*cursor); cursor++) {
   }
+  return true;
+}
 
-  for (; !isblank(*cursor); cursor++) {
-    if (*cursor == '\n') {
-      return false;
-    }
-    url.push_back(*cursor);
-  }
-  if (url.empty()) {
+/**
+ * @brief 读取行中最后一个以 \r\n 结尾的部分。
+ * @param cursor 开头。
+ * @param end 行尾。
+ * @param value 读取到的内容。
+ * @return bool 内容为空或 \r 后面不是 \n 时返回 false。
+ */
+static bool parseLast(const char* cursor, const char* end,
+                      std::string& value) {
+  static const char kStops[] = {'\r', '\n'};
+  const char* stop = scan::findAnyOf(cursor, end, kStops, sizeof(kStops));
+  if (stop == end || *stop == '\n' || stop == cursor) {
     return false;
   }
-  cursor++;
-  for (; isblank(*cursor); cursor++) {
-    if (*cursor == '\n') {
-      return false;
-    }
-  }
+  value.assign(cursor, stop);
+  return stop + 1 < end && stop[1] == '\n';
+}
 
-  for (; *cursor != '\r'; cursor++) {
-    if (*cursor == '\n') {
-      return false;
-    }
-    version.push_back(*cursor);
-  }
-  if (version.empty()) {
-    return false;
-  }
-  cursor++;
-  return *cursor == '\n';
+bool parseReqStartLine(const char* line, size_t len, std::string& method,
+                       std::string& url, std::string& version) {
+  const char* cursor = line;
+  const char* end = line + len;
+  method.clear();
+  url.clear();
+  version.clear();
+
+  return parseWord(cursor, end, method) && parseWord(cursor, end, url) &&
+         parseLast(cursor, end, version);
 }
 
-bool parseRespStartLine(const char* line, std::string& version, int& code,
-                        std::string& reason) {
+bool parseRespStartLine(const char* line, size_t len, std::string& version,
+                        int& code, std::string& reason) {
   const char* cursor = line;
+  const char* end = line + len;
   version.clear();
   code = 0;
   reason.clear();
 
-  for (; !isblank(*cursor); cursor++) {
-    if (*cursor == '\n') {
-      return false;
-    }
-    version.push_back(*cursor);
-  }
-  if (version.empty()) {
+  if (!parseWord(cursor, end, version)) {
     return false;
   }
-  cursor++;
-  for (; isblank(*cursor); cursor++) {
-    if (*cursor == '\n') {
-      return false;
-    }
-  }
 
   std::string code_str;
-  for (; !isblank(*cursor); cursor++) {
-    if (*cursor == '\n') {
-      return false;
-    }
-    code_str.push_back(*cursor);
+  if (!parseWord(cursor, end, code_str)) {
+    return false;
   }
   if (code_str.length() != 3) {
     return false;
@@ -101,58 +87,27 @@ bool parseRespStartLine(const char* line, std::string& version, int& code,
   int digit2 = code_str[1] - '0';
   int digit3 = code_str[2] - '0';
   code = digit1 * 100 + digit2 * 10 + digit3;
-  cursor++;
-  for (; isblank(*cursor); cursor++) {
-    if (*cursor == '\n') {
-      return false;
-    }
-  }
 
-  for (; *cursor != '\r'; cursor++) {
-    if (*cursor == '\n') {
-      return false;
-    }
-    reason.push_back(*cursor);
-  }
-  if (reason.empty()) {
-    return false;
-  }
-  cursor++;
-  return *cursor == '\n';
+  return parseLast(cursor, end, reason);
 }
 
-bool parseHeader(const char* line, std::string& name, std::string& value) {
-  const char* cursor = line;
+bool parseHeader(const char* line, size_t len, std::string& name,
+                 std::string& value) {
+  const char* end = line + len;
   name.clear();
   value.clear();
 
-  for (; *cursor != ':'; cursor++) {
-    if (*cursor == '\n') {
-      return false;
-    }
-    name.push_back(*cursor);
-  }
-  if (name.empty()) {
+  static const char kStops[] = {':', '\n'};
+  const char* colon = scan::findAnyOf(line, end, kStops, sizeof(kStops));
+  if (colon == end || *colon == '\n' || colon == line) {
     return false;
   }
-  cursor++;
-  for (; isblank(*cursor); cursor++) {
-    if (*cursor == '\n') {
-      return false;
-    }
-  }
+  name.assign(line, colon);
 
-  for (; *cursor != '\r'; cursor++) {
-    if (*cursor == '\n') {
-      return false;
-    }
-    value.push_back(*cursor);
-  }
-  if (value.empty()) {
-    return false;
+  const char* cursor = colon + 1;
+  for (; cursor < end && isblank(*cursor); cursor++) {
   }
-  cursor++;
-  return *cursor == '\n';
+  return parseLast(cursor, end, value);
 }
 
 }  // namespace protocol
@@ -1,7 +1,10 @@
 #include "coro/http/protocol/read_write.hpp"
 
+#include "coro/arena.hpp"
 #include "coro/http/protocol/error.hpp"
 #include "coro/http/protocol/parse.hpp"
+#include "coro/probe.hpp"
+#include "coro/sched/sched.hpp"
 
 namespace coro {
 namespace http {
@@ -10,32 +13,34 @@ namespace protocol {
 using Headers = std::vector<std::pair<std::string, std::string>>;
 
 static Promise<void> readHeaders(Stream stream, size_t line_len_limit,
-                                 Headers* headers, std::shared_ptr<char> buf) {
+                                 Headers* headers) {
   Promise<void> promise;
 
-  stream->readline(buf.get(), line_len_limit)
-      .then([promise, stream, line_len_limit, headers, buf](size_t n) {
+  stream->readUntil('\n', line_len_limit)
+      .then([promise, stream, line_len_limit,
+             headers](boost::string_view line) {
+        size_t n = line.size();
         // 超出行长限制。
-        if (n == line_len_limit && buf.get()[n - 1] != '\n') {
+        if (n == line_len_limit && line[n - 1] != '\n') {
           std::error_code error(Errc::kLineTooLong, errorCategory());
           promise.reject(std::move(error));
           return;
         }
         // 读取的 EOF
-        if (n == 0 || buf.get()[n - 1] != '\n') {
+        if (n == 0 || line[n - 1] != '\n') {
           std::error_code error(Errc::kEof, errorCategory());
           promise.reject(std::move(error));
           return;
         }
 
         // 读取到空行则结束。
-        if (n == 2 && buf.get()[0] == '\r' && buf.get()[1] == '\n') {
+        if (line == "\r\n") {
           promise.resolve();
           return;
         }
 
         std::string name, value;
-        bool ok = parseHeader(buf.get(), name, value);
+        bool ok = parseHeader(line.data(), n, name, value);
         // 标头行格式错误。
         if (!ok) {
           std::error_code error(Errc::kBadHeader, errorCategory());
@@ -44,13 +49,13 @@ static Promise<void> readHeaders(Stream stream, size_t line_len_limit,
         }
         headers->push_back({std::move(name), std::move(value)});
 
-        readHeaders(stream, line_len_limit, headers, buf)
+        readHeaders(stream, line_len_limit, headers)
             .then([promise]() { promise.resolve(); })
             .except([promise](std::error_code error) {
               promise.reject(std::move(error));
             });
       })
-      .except([promise](size_t n, std::error_code error) {
+      .except([promise](boost::string_view line, std::error_code error) {
         promise.reject(std::move(error));
       });
 
@@ -59,27 +64,28 @@ static Promise<void> readHeaders(Stream stream, size_t line_len_limit,
 
 Promise<Request> readReq(Stream stream, size_t line_len_limit) {
   Promise<Request> promise;
-  auto buf = std::shared_ptr<char>(new char[line_len_limit],
-                                   [](char* ptr) { delete[] ptr; });
-  auto req = std::make_shared<Request>();
+  auto req = makeShared<Request>();
+  uint64_t coro_id = sched::currentPtr()->id();
 
-  stream->readline(buf.get(), line_len_limit)
-      .then([promise, buf, stream, line_len_limit, req](size_t n) {
+  stream->readUntil('\n', line_len_limit)
+      .then([promise, stream, line_len_limit, req,
+             coro_id](boost::string_view line) {
+        size_t n = line.size();
         // 超出行长限制。
-        if (n == line_len_limit && buf.get()[n - 1] != '\n') {
+        if (n == line_len_limit && line[n - 1] != '\n') {
           std::error_code error(Errc::kLineTooLong, errorCategory());
           promise.reject(std::move(error));
           return;
         }
         // 读取的 EOF
-        if (n == 0 || buf.get()[n - 1] != '\n') {
+        if (n == 0 || line[n - 1] != '\n') {
           std::error_code error(Errc::kEof, errorCategory());
           promise.reject(std::move(error));
           return;
         }
 
-        bool ok =
-            parseReqStartLine(buf.get(), req->method, req->url, req->version);
+        bool ok = parseReqStartLine(line.data(), n, req->method, req->url,
+                                    req->version);
         // 起始行格式错误。
         if (!ok) {
           std::error_code error(Errc::kBadStartLine, errorCategory());
@@ -87,22 +93,54 @@ Promise<Request> readReq(Stream stream, size_t line_len_limit) {
           return;
         }
 
-        readHeaders(stream, line_len_limit, &req->headers, buf)
-            .then([promise, req]() { promise.resolve(std::move(*req)); })
+        readHeaders(stream, line_len_limit, &req->headers)
+            .then([promise, req, coro_id]() {
+              CORO_PROBE3(http_read_req, coro_id, req->method.c_str(),
+                          req->url.c_str());
+              promise.resolve(std::move(*req));
+            })
             .except([promise](std::error_code error) {
               promise.reject(std::move(error));
             });
       })
-      .except([promise](size_t n, std::error_code error) {
+      .except([promise](boost::string_view line, std::error_code error) {
         promise.reject(std::move(error));
       });
+  sched::setWaitTag("http.readReq");
   return promise;
 }
 
-Promise<void> writeReq(Stream stream, const Request& req) {
+/**
+ * @brief 待写入的消息，起始行和标头在 head 中，与正文一起聚集写入。
+ */
+struct Message {
+  std::string head;
+  boost::asio::const_buffer bufs[2];
+};
+
+/**
+ * @brief 写入消息的头部和正文。正文非空时用一次 writev 写入，避免拷贝正文。
+ * @param stream 流。
+ * @param msg 消息，在 Promise 敲定之前必须保持有效。
+ * @param body 正文。
+ * @return Promise<size_t> 写入的字节数。
+ */
+static Promise<size_t> writeMessage(const Stream& stream, Message* msg,
+                                    boost::string_view body) {
+  if (body.empty()) {
+    return stream->write(msg->head.data(), msg->head.length());
+  }
+  msg->bufs[0] = boost::asio::buffer(msg->head);
+  msg->bufs[1] = boost::asio::buffer(body.data(), body.size());
+  return stream->writev(msg->bufs, 2);
+}
+
+Promise<void> writeReq(Stream stream, const Request& req,
+                       boost::string_view body) {
   Promise<void> promise;
 
-  auto bytes = std::make_shared<std::string>();
+  auto msg = makeShared<Message>();
+  std::string* bytes = &msg->head;
   bytes->append(req.method);
   bytes->push_back(' ');
   bytes->append(req.url);
@@ -117,38 +155,45 @@ Promise<void> writeReq(Stream stream, const Request& req) {
   }
   bytes->append("\r\n");
 
-  stream->write(bytes->data(), bytes->length())
-      .then([promise](size_t n) { promise.resolve(); })
-      .except([promise](size_t n, std::error_code error) {
+  uint64_t coro_id = sched::currentPtr()->id();
+  writeMessage(stream, msg.get(), body)
+      .then([promise, coro_id](size_t n) {
+        CORO_PROBE2(http_write_req, coro_id, 0);
+        promise.resolve();
+      })
+      .except([promise, coro_id](size_t n, std::error_code error) {
+        CORO_PROBE2(http_write_req, coro_id, error.value());
         promise.reject(std::move(error));
       })
-      .finally([bytes]() {});
+      .finally([msg]() {});
 
+  sched::setWaitTag("http.writeReq");
   return promise;
 }
 
 Promise<Response> readResp(Stream stream, size_t line_len_limit) {
   Promise<Response> promise;
-  auto buf = std::shared_ptr<char>(new char[line_len_limit],
-                                   [](char* ptr) { delete[] ptr; });
-  auto resp = std::make_shared<Response>();
+  auto resp = makeShared<Response>();
+  uint64_t coro_id = sched::currentPtr()->id();
 
-  stream->readline(buf.get(), line_len_limit)
-      .then([promise, buf, stream, line_len_limit, resp](size_t n) {
+  stream->readUntil('\n', line_len_limit)
+      .then([promise, stream, line_len_limit, resp,
+             coro_id](boost::string_view line) {
+        size_t n = line.size();
         // 超出行长限制。
-        if (n == line_len_limit && buf.get()[n - 1] != '\n') {
+        if (n == line_len_limit && line[n - 1] != '\n') {
           std::error_code error(Errc::kLineTooLong, errorCategory());
           promise.reject(std::move(error));
           return;
         }
         // 读取的 EOF
-        if (n == 0 || buf.get()[n - 1] != '\n') {
+        if (n == 0 || line[n - 1] != '\n') {
           std::error_code error(Errc::kEof, errorCategory());
           promise.reject(std::move(error));
           return;
         }
 
-        bool ok = parseRespStartLine(buf.get(), resp->version, resp->code,
+        bool ok = parseRespStartLine(line.data(), n, resp->version, resp->code,
                                      resp->reason);
         // 起始行格式错误。
         if (!ok) {
@@ -157,22 +202,28 @@ Promise<Response> readResp(Stream stream, size_t line_len_limit) {
           return;
         }
 
-        readHeaders(stream, line_len_limit, &resp->headers, buf)
-            .then([promise, resp]() { promise.resolve(std::move(*resp)); })
+        readHeaders(stream, line_len_limit, &resp->headers)
+            .then([promise, resp, coro_id]() {
+              CORO_PROBE2(http_read_resp, coro_id, resp->code);
+              promise.resolve(std::move(*resp));
+            })
             .except([promise](std::error_code error) {
               promise.reject(std::move(error));
             });
       })
-      .except([promise](size_t n, std::error_code error) {
+      .except([promise](boost::string_view line, std::error_code error) {
         promise.reject(std::move(error));
       });
+  sched::setWaitTag("http.readResp");
   return promise;
 }
 
-Promise<void> writeResp(Stream stream, const Response& resp) {
+Promise<void> writeResp(Stream stream, const Response& resp,
+                        boost::string_view body) {
   Promise<void> promise;
 
-  auto bytes = std::make_shared<std::string>();
+  auto msg = makeShared<Message>();
+  std::string* bytes = &msg->head;
   bytes->append(resp.version);
   bytes->push_back(' ');
   bytes->append(std::to_string(resp.code));
@@ -187,13 +238,20 @@ Promise<void> writeResp(Stream stream, const Response& resp) {
   }
   bytes->append("\r\n");
 
-  stream->write(bytes->data(), bytes->length())
-      .then([promise](size_t n) { promise.resolve(); })
-      .except([promise](size_t n, std::error_code error) {
+  uint64_t coro_id = sched::currentPtr()->id();
+  int code = resp.code;
+  writeMessage(stream, msg.get(), body)
+      .then([promise, coro_id, code](size_t n) {
+        CORO_PROBE3(http_write_resp, coro_id, code, 0);
+        promise.resolve();
+      })
+      .except([promise, coro_id, code](size_t n, std::error_code error) {
+        CORO_PROBE3(http_write_resp, coro_id, code, error.value());
         promise.reject(std::move(error));
       })
-      .finally([bytes]() {});
+      .finally([msg]() {});
 
+  sched::setWaitTag("http.writeResp");
   return promise;
 }
 
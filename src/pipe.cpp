@@ -0,0 +1,271 @@
+#include "coro/pipe.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <system_error>
+#include <vector>
+
+#include "coro/sched/sched.hpp"
+
+namespace coro {
+namespace impl {
+
+/**
+ * @brief 阻塞的读操作，缓冲区为空时等待写端写入。
+ */
+struct PendingRead {
+  Promise<size_t> promise;
+  char* buf;
+  size_t len;
+};
+
+/**
+ * @brief 阻塞的写操作，缓冲区已满时等待读端读取。
+ */
+struct PendingWrite {
+  Promise<size_t> promise;
+  const char* buf;
+  size_t len;
+  size_t written;  // 已经写入的字节数。
+};
+
+/**
+ * @brief 管道一个方向的状态，包括环形缓冲区和阻塞在该方向上的读写操作。
+ * 多个协程同时读写时按调用的顺序排队。
+ */
+struct PipeChannel {
+  std::vector<char> data;     // 环形缓冲区。
+  size_t head = 0;            // 第一个未读字节的位置。
+  size_t size = 0;            // 未读字节数。
+  bool read_closed = false;   // 读端是否已关闭。
+  bool write_closed = false;  // 写端是否已关闭。
+
+  std::deque<PendingRead> readers;   // 阻塞的读操作，只在缓冲区为空时存在。
+  std::deque<PendingWrite> writers;  // 阻塞的写操作，只在缓冲区已满时存在。
+
+  /**
+   * @brief 向环形缓冲区写入尽可能多的字节。
+   * @return size_t 写入的字节数。
+   */
+  size_t push(const char* buf, size_t len) {
+    size_t capacity = data.size();
+    len = std::min(len, capacity - size);
+    if (len == 0) {
+      return 0;
+    }
+    size_t tail = (head + size) % capacity;
+    size_t first = std::min(len, capacity - tail);
+    memcpy(data.data() + tail, buf, first);
+    memcpy(data.data(), buf + first, len - first);
+    size += len;
+    return len;
+  }
+
+  /**
+   * @brief 从环形缓冲区读取尽可能多的字节。
+   * @return size_t 读取的字节数。
+   */
+  size_t pop(char* buf, size_t len) {
+    size_t capacity = data.size();
+    len = std::min(len, size);
+    if (len == 0) {
+      return 0;
+    }
+    size_t first = std::min(len, capacity - head);
+    memcpy(buf, data.data() + head, first);
+    memcpy(buf + first, data.data(), len - first);
+    head = size == len ? 0 : (head + len) % capacity;
+    size -= len;
+    return len;
+  }
+
+  /**
+   * @brief 按顺序将阻塞的写操作的数据拷贝到 buf（为 nullptr 时拷贝到
+   * 环形缓冲区），直至 buf 或环形缓冲区已满。
+   * @param buf 读操作的缓冲区。
+   * @param len 读操作的缓冲区大小。
+   * @param done 全部完成的写操作被追加到这里，由调用者兑现。
+   * @return size_t 拷贝到 buf 的字节数。
+   */
+  size_t drainWriters(char* buf, size_t len, std::vector<PendingWrite>* done) {
+    size_t copied = 0;
+    while (!writers.empty()) {
+      PendingWrite& writer = writers.front();
+      size_t n;
+      if (buf) {
+        n = std::min(len - copied, writer.len - writer.written);
+        memcpy(buf + copied, writer.buf + writer.written, n);
+        copied += n;
+      } else {
+        n = push(writer.buf + writer.written, writer.len - writer.written);
+      }
+      writer.written += n;
+      if (writer.written < writer.len) {
+        break;
+      }
+      done->push_back(std::move(writer));
+      writers.pop_front();
+    }
+    return copied;
+  }
+};
+
+/**
+ * @brief 管道两端共享的状态。channels[i] 是第 i 端读取、另一端写入的方向。
+ */
+struct PipeState {
+  PipeChannel channels[2];
+};
+
+Promise<size_t> PipeStream::readSome(char* buf, size_t len) {
+  Promise<size_t> promise;
+  if (len == 0) {
+    promise.resolve(0);
+    return promise;
+  }
+
+  PipeChannel& channel = state_->channels[side_];
+  if (channel.read_closed) {
+    promise.reject(0, std::make_error_code(std::errc::bad_file_descriptor));
+    return promise;
+  }
+
+  // 先修改管道的状态，再敲定 Promise，因为 Promise 的回调可能再次读写管道。
+  size_t n = 0;
+  std::vector<PendingWrite> done;
+  // 已有读操作在排队时缓冲区一定为空，直接排在它们之后。
+  if (channel.readers.empty()) {
+    if (channel.size > 0) {
+      n = channel.pop(buf, len);
+      channel.drainWriters(nullptr, 0, &done);
+    } else {
+      // 容量为 0 的管道直接从阻塞的写操作拷贝。
+      n = channel.drainWriters(buf, len, &done);
+    }
+  }
+
+  if (n > 0) {
+    promise.resolve(n);
+  } else if (channel.write_closed) {
+    promise.resolve(0);
+  } else {
+    channel.readers.push_back(PendingRead{promise, buf, len});
+    sched::setWaitTag("pipe.read");
+  }
+  for (auto& writer : done) {
+    writer.promise.resolve(writer.len);
+  }
+  return promise;
+}
+
+Promise<size_t> PipeStream::write(const char* buf, size_t len) {
+  Promise<size_t> promise;
+  PipeChannel& channel = state_->channels[1 - side_];
+  if (channel.write_closed) {
+    promise.reject(0, std::make_error_code(std::errc::bad_file_descriptor));
+    return promise;
+  }
+  if (channel.read_closed) {
+    promise.reject(0, std::make_error_code(std::errc::broken_pipe));
+    return promise;
+  }
+  if (len == 0) {
+    promise.resolve(0);
+    return promise;
+  }
+
+  // 已有写操作在排队时缓冲区一定已满，直接排在它们之后，保证数据的顺序。
+  // 否则先按顺序拷贝到阻塞的读操作的缓冲区，剩余的数据写入环形缓冲区。
+  size_t written = 0;
+  std::vector<PendingRead> done;
+  if (channel.writers.empty()) {
+    while (written < len && !channel.readers.empty()) {
+      PendingRead reader = std::move(channel.readers.front());
+      channel.readers.pop_front();
+      reader.len = std::min(len - written, reader.len);
+      memcpy(reader.buf, buf + written, reader.len);
+      written += reader.len;
+      done.push_back(std::move(reader));
+    }
+    written += channel.push(buf + written, len - written);
+  }
+
+  if (written == len) {
+    promise.resolve(len);
+  } else {
+    channel.writers.push_back(PendingWrite{promise, buf, len, written});
+    sched::setWaitTag("pipe.write");
+  }
+  for (auto& reader : done) {
+    reader.promise.resolve(reader.len);
+  }
+  return promise;
+}
+
+void PipeStream::close() {
+  PipeChannel& in = state_->channels[side_];
+  PipeChannel& out = state_->channels[1 - side_];
+  if (in.read_closed && out.write_closed) {
+    return;
+  }
+
+  // 本端读取的方向：丢弃未读的数据，本端的读操作被取消，对端的写操作失败。
+  in.read_closed = true;
+  in.size = 0;
+  std::deque<PendingRead> own_readers, peer_readers;
+  std::deque<PendingWrite> own_writers, peer_writers;
+  own_readers.swap(in.readers);
+  peer_writers.swap(in.writers);
+  // 本端写入的方向：本端的写操作被取消，对端的读操作读取到 EOF。
+  out.write_closed = true;
+  own_writers.swap(out.writers);
+  peer_readers.swap(out.readers);
+
+  auto canceled = std::make_error_code(std::errc::operation_canceled);
+  for (auto& reader : own_readers) {
+    reader.promise.reject(0, canceled);
+  }
+  for (auto& writer : peer_writers) {
+    writer.promise.reject(writer.written,
+                          std::make_error_code(std::errc::broken_pipe));
+  }
+  for (auto& writer : own_writers) {
+    writer.promise.reject(writer.written, canceled);
+  }
+  for (auto& reader : peer_readers) {
+    reader.promise.resolve(0);
+  }
+}
+
+void PipeStream::shutdownWrite() {
+  PipeChannel& out = state_->channels[1 - side_];
+  if (out.write_closed) {
+    return;
+  }
+
+  out.write_closed = true;
+  std::deque<PendingWrite> own_writers;
+  std::deque<PendingRead> peer_readers;
+  own_writers.swap(out.writers);
+  peer_readers.swap(out.readers);
+  auto canceled = std::make_error_code(std::errc::operation_canceled);
+  for (auto& writer : own_writers) {
+    writer.promise.reject(writer.written, canceled);
+  }
+  for (auto& reader : peer_readers) {
+    reader.promise.resolve(0);
+  }
+}
+
+}  // namespace impl
+
+std::pair<PipeStream, PipeStream> pipe(size_t capacity) {
+  auto state = std::make_shared<impl::PipeState>();
+  state->channels[0].data.resize(capacity);
+  state->channels[1].data.resize(capacity);
+  return {std::make_shared<impl::PipeStream>(state, 0),
+          std::make_shared<impl::PipeStream>(state, 1)};
+}
+
+}  // namespace coro
@@ -0,0 +1,239 @@
+#include "coro/pump.hpp"
+
+#include <boost/asio/error.hpp>
+#include <memory>
+#include <utility>
+
+#include "coro/tcp/conn.hpp"
+
+namespace coro {
+
+/**
+ * @brief 判断错误是否表示读取到 EOF。tcp::Conn 读取到 EOF 时
+ * 拒绝 Promise，而不是返回 0。
+ */
+static bool isEof(const std::error_code& error) {
+  return error == std::error_code(
+                      boost::asio::error::make_error_code(
+                          boost::asio::error::eof));
+}
+
+/**
+ * @brief pump 两个方向共享的状态。
+ */
+struct PumpState {
+  Stream a;
+  Stream b;
+  PumpResult result;
+  std::error_code error;  // 第一个出错的方向的错误。
+  int running = 2;        // 尚未结束的方向的个数。
+  Promise<PumpResult> promise;
+
+  /**
+   * @brief 一个方向结束时调用。第一次出错时关闭两个流，以便另一个方向结束。
+   * @param error 该方向的错误，正常结束时为空。
+   */
+  void finish(std::error_code error) {
+    if (error && !this->error) {
+      this->error = error;
+      a->close();
+      b->close();
+    }
+    if (--running > 0) {
+      return;
+    }
+    if (this->error) {
+      promise.reject(result, this->error);
+    } else {
+      promise.resolve(result);
+    }
+  }
+};
+
+/**
+ * @brief pump 的一个方向，将 src 中的数据转发到 dst。
+ * 读写操作可能同步完成，回调中不直接发起下一个操作，而是由 run 循环发起，
+ * 避免连续同步完成时递归过深。
+ */
+class PumpDirection : public std::enable_shared_from_this<PumpDirection> {
+ public:
+  PumpDirection(std::shared_ptr<PumpState> state, Stream src, Stream dst,
+                uint64_t* counter, size_t buffer_size)
+      : state_(std::move(state)),
+        src_(std::move(src)),
+        dst_(std::move(dst)),
+        counter_(counter),
+        buffer_size_(buffer_size) {
+    src_conn_ = std::dynamic_pointer_cast<tcp::impl::Conn>(src_);
+    dst_conn_ = std::dynamic_pointer_cast<tcp::impl::Conn>(dst_);
+    if (!src_conn_ || !dst_conn_) {
+      bufs_[0].reset(new char[buffer_size_]);
+      bufs_[1].reset(new char[buffer_size_]);
+    }
+  }
+
+  /**
+   * @brief 发起所有可以发起的操作，直至没有新的进展。
+   */
+  void run() {
+    if (finished_) {
+      return;
+    }
+    if (running_) {
+      again_ = true;
+      return;
+    }
+    running_ = true;
+    do {
+      again_ = false;
+      if (src_conn_ && dst_conn_) {
+        spliceNext();
+      } else {
+        readNext();
+        writeNext();
+      }
+    } while (again_ && !finished_);
+    running_ = false;
+
+    if (!finished_ && eof_ && !reading_ && !writing_ && filled_ == 0) {
+      finished_ = true;
+      dst_->shutdownWrite();
+      state_->finish(std::error_code());
+    }
+  }
+
+ private:
+  /**
+   * @brief 用 splice 转发下一批数据。
+   */
+  void spliceNext() {
+    if (reading_ || eof_) {
+      return;
+    }
+    reading_ = true;
+    auto self = shared_from_this();
+    dst_conn_->splice(src_conn_, buffer_size_)
+        .then([self](size_t n) {
+          self->reading_ = false;
+          *self->counter_ += n;
+          self->eof_ = n == 0;
+          self->run();
+        })
+        .except([self](size_t n, std::error_code error) {
+          self->reading_ = false;
+          *self->counter_ += n;
+          self->fail(error);
+        });
+  }
+
+  /**
+   * @brief 有空闲的缓冲区时读取到该缓冲区。
+   */
+  void readNext() {
+    if (reading_ || eof_ || filled_ == 2) {
+      return;
+    }
+    reading_ = true;
+    auto self = shared_from_this();
+    src_->read(bufs_[read_slot_].get(), buffer_size_)
+        .then([self](size_t n) { self->onRead(n); })
+        .except([self](size_t n, std::error_code error) {
+          if (isEof(error)) {
+            self->onRead(0);
+          } else {
+            self->reading_ = false;
+            self->fail(error);
+          }
+        });
+  }
+
+  /**
+   * @brief 读取完成时调用。
+   * @param n 读取到的字节数，为 0 表示 EOF。
+   */
+  void onRead(size_t n) {
+    reading_ = false;
+    if (n == 0) {
+      eof_ = true;
+    } else {
+      lens_[read_slot_] = n;
+      read_slot_ ^= 1;
+      filled_++;
+    }
+    run();
+  }
+
+  /**
+   * @brief 没有正在进行的写入时，写入最早读取到数据的缓冲区。
+   */
+  void writeNext() {
+    if (writing_ || filled_ == 0) {
+      return;
+    }
+    writing_ = true;
+    auto self = shared_from_this();
+    dst_->write(bufs_[write_slot_].get(), lens_[write_slot_])
+        .then([self](size_t n) {
+          self->writing_ = false;
+          *self->counter_ += n;
+          self->write_slot_ ^= 1;
+          self->filled_--;
+          self->run();
+        })
+        .except([self](size_t n, std::error_code error) {
+          self->writing_ = false;
+          *self->counter_ += n;
+          self->fail(error);
+        });
+  }
+
+  /**
+   * @brief 出错时结束该方向。
+   * @param error 错误码。
+   */
+  void fail(std::error_code error) {
+    if (finished_) {
+      return;
+    }
+    finished_ = true;
+    again_ = false;
+    state_->finish(std::move(error));
+  }
+
+  std::shared_ptr<PumpState> state_;
+  Stream src_;
+  Stream dst_;
+  // src 和 dst 都是 tcp::Conn 时使用 splice，否则为空。
+  std::shared_ptr<tcp::impl::Conn> src_conn_;
+  std::shared_ptr<tcp::impl::Conn> dst_conn_;
+  uint64_t* counter_;  // 该方向转发的字节数，指向 state_->result 的成员。
+  size_t buffer_size_;
+  std::unique_ptr<char[]> bufs_[2];  // 双缓冲区，splice 时不分配。
+  size_t lens_[2] = {0, 0};          // 缓冲区中的字节数。
+  int read_slot_ = 0;                // 下一次读取使用的缓冲区。
+  int write_slot_ = 0;               // 下一次写入使用的缓冲区。
+  int filled_ = 0;                   // 已读取到数据、尚未写完的缓冲区个数。
+  bool reading_ = false;             // 是否正在读取（或 splice）。
+  bool writing_ = false;             // 是否正在写入。
+  bool eof_ = false;                 // src 是否已读取到 EOF。
+  bool finished_ = false;            // 该方向是否已结束。
+  bool running_ = false;             // 是否正在执行 run 循环。
+  bool again_ = false;               // run 循环是否需要再执行一次。
+};
+
+Promise<PumpResult> pump(Stream a, Stream b, size_t buffer_size) {
+  auto state = std::make_shared<PumpState>();
+  state->a = a;
+  state->b = b;
+  auto forward = std::make_shared<PumpDirection>(state, a, b,
+                                                 &state->result.a_to_b,
+                                                 buffer_size);
+  auto backward = std::make_shared<PumpDirection>(state, b, a,
+                                                  &state->result.b_to_a,
+                                                  buffer_size);
+  forward->run();
+  backward->run();
+  return state->promise;
+}
+
+}  // namespace coro
@@ -1,5 +1,8 @@
 #include "coro/redis/client/client.hpp"
 
+#include "coro/probe.hpp"
+#include "coro/sched/sched.hpp"
+
 namespace coro {
 namespace redis {
 namespace client {
@@ -21,6 +24,7 @@ Promise<void> Client::connect(const std::string& host, uint16_t port) {
       .except([promise](tcp::Conn conn, std::error_code error) {
         promise.reject(std::move(error));
       });
+  sched::setWaitTag("redis.connect");
   return promise;
 }
 
@@ -32,20 +36,26 @@ Promise<Client::Response> Client::exec(Request req) {
     array->mut_fields().push_back(field);
   }
   auto conn = conn_;
+  uint64_t coro_id = sched::currentPtr()->id();
+  CORO_PROBE1(redis_exec_start, coro_id);
   protocol::writeField(conn_, array)
-      .then([this, promise]() {
+      .then([this, promise, coro_id]() {
         protocol::readField(conn_)
-            .then([promise](std::shared_ptr<protocol::Field> resp) {
+            .then([promise, coro_id](std::shared_ptr<protocol::Field> resp) {
+              CORO_PROBE2(redis_exec_done, coro_id, 0);
               promise.resolve(resp);
             })
-            .except([promise](std::shared_ptr<protocol::Field> resp,
-                              std::error_code error) {
+            .except([promise, coro_id](std::shared_ptr<protocol::Field> resp,
+                                       std::error_code error) {
+              CORO_PROBE2(redis_exec_done, coro_id, error.value());
               promise.reject(std::move(error));
             });
       })
-      .except([promise](std::error_code error) {
+      .except([promise, coro_id](std::error_code error) {
+        CORO_PROBE2(redis_exec_done, coro_id, error.value());
         promise.reject(std::move(error));
       });
+  sched::setWaitTag("redis.exec");
   return promise;
 }
 
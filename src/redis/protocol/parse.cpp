@@ -2,17 +2,30 @@
 
 #include <cstring>
 
+#include "coro/scan.hpp"
+
 namespace coro {
 namespace redis {
 namespace protocol {
 
+// 简单字符串和错误中不能包含 \r\n，第一个 \r\n 必须位于行尾。
+static bool endsWithFirstCrlf(const char* line, size_t n) {
+  return n >= 3 && scan::findCrlf(line, line + n) == line + n - 2;
+}
+
 std::shared_ptr<SimpleStringField> parseSimpleString(const char* line,
                                                      size_t n) {
+  if (!endsWithFirstCrlf(line, n)) {
+    return nullptr;
+  }
   std::string value(line + 1, n - 3);
   return SimpleStringField::from(std::move(value));
 }
 
 std::shared_ptr<ErrorField> parseError(const char* line, size_t n) {
+  if (!endsWithFirstCrlf(line, n)) {
+    return nullptr;
+  }
   std::string value(line + 1, n - 3);
   return ErrorField::from(std::move(value));
 }
@@ -39,8 +52,9 @@ std::shared_ptr<IntegerField> parseInteger(const char* line, size_t n) {
     }
     u64 *= 10;
     if (u64 > (1ULL << 63) - digit) {
-      u64 += digit;
+      return nullptr;
     }
+    u64 += digit;
   }
   if (u64 == (1ULL << 63)) {
     if (!positive) {
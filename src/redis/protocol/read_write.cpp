@@ -1,7 +1,9 @@
 #include "coro/redis/protocol/read_write.hpp"
 
+#include "coro/arena.hpp"
 #include "coro/redis/protocol/error.hpp"
 #include "coro/redis/protocol/parse.hpp"
+#include "coro/sched/sched.hpp"
 
 namespace coro {
 namespace redis {
@@ -11,19 +13,28 @@ Promise<std::shared_ptr<BulkStringField>> readBulkString(Stream stream,
                                                          size_t len) {
   Promise<std::shared_ptr<BulkStringField>> promise;
   size_t buf_size = len + 2;
-  auto buf = std::shared_ptr<char>(new char[buf_size],
-                                   [](char* ptr) { delete[] ptr; });
 
-  stream->readn(buf.get(), buf_size)
-      .then([promise, buf, buf_size](size_t n) {
+  // 整个字符串已经在读缓冲区中时，直接从读缓冲区构造，无需临时缓冲区。
+  boost::string_view buffered = stream->peek();
+  if (buffered.size() >= buf_size) {
+    auto str = std::string(buffered.data(), len);
+    stream->consume(buf_size);
+    promise.resolve(BulkStringField::from(std::move(str)));
+    return promise;
+  }
+
+  // 否则直接读入字符串，连同结尾的 \r\n，之后再截掉。
+  auto str = makeShared<std::string>(buf_size, '\0');
+  stream->readn(&(*str)[0], buf_size)
+      .then([promise, str, len, buf_size](size_t n) {
         // 读取的 EOF
         if (n != buf_size) {
           std::error_code error(Errc::kEof, errorCategory());
           promise.reject(std::move(error));
           return;
         }
-        auto str = std::string(buf.get(), buf_size - 2);
-        promise.resolve(BulkStringField::from(std::move(str)));
+        str->resize(len);
+        promise.resolve(BulkStringField::from(std::move(*str)));
       })
       .except([promise](size_t n, std::error_code error) {
         promise.reject(std::move(error));
@@ -60,27 +71,28 @@ Promise<void> readArray(Stream stream, size_t line_len_limit,
 Promise<std::shared_ptr<Field>> readField(Stream stream,
                                           size_t line_len_limit) {
   Promise<std::shared_ptr<Field>> promise;
-  auto buf = std::shared_ptr<char>(new char[line_len_limit],
-                                   [](char* ptr) { delete[] ptr; });
 
-  stream->readline(buf.get(), line_len_limit)
-      .then([promise, stream, buf, line_len_limit](size_t n) {
+  // 直接在流的读缓冲区上解析，解析完成后才会继续读取。
+  stream->readUntil('\n', line_len_limit)
+      .then([promise, stream, line_len_limit](boost::string_view line) {
+        size_t n = line.size();
+        const char* buf = line.data();
         // 超出行长限制。
-        if (n == line_len_limit && buf.get()[n - 1] != '\n') {
+        if (n == line_len_limit && buf[n - 1] != '\n') {
           std::error_code error(Errc::kLineTooLong, errorCategory());
           promise.reject(std::move(error));
           return;
         }
         // 读取的 EOF
-        if (n == 0 || buf.get()[n - 1] != '\n') {
+        if (n == 0 || buf[n - 1] != '\n') {
           std::error_code error(Errc::kEof, errorCategory());
           promise.reject(std::move(error));
           return;
         }
 
-        switch (buf.get()[0]) {
+        switch (buf[0]) {
           case '+': {
-            auto result = parseSimpleString(buf.get(), n);
+            auto result = parseSimpleString(buf, n);
             if (result) {
               promise.resolve(result);
             } else {
@@ -90,7 +102,7 @@ Promise<std::shared_ptr<Field>> readField(Stream stream,
             return;
           }
           case '-': {
-            auto result = parseError(buf.get(), n);
+            auto result = parseError(buf, n);
             if (result) {
               promise.resolve(result);
             } else {
@@ -100,7 +112,7 @@ Promise<std::shared_ptr<Field>> readField(Stream stream,
             return;
           }
           case ':': {
-            auto result = parseInteger(buf.get(), n);
+            auto result = parseInteger(buf, n);
             if (result) {
               promise.resolve(result);
             } else {
@@ -110,7 +122,7 @@ Promise<std::shared_ptr<Field>> readField(Stream stream,
             return;
           }
           case '$': {
-            auto len = parseBulkStringLength(buf.get(), n);
+            auto len = parseBulkStringLength(buf, n);
             if (len == -2) {
               std::error_code error(Errc::kBadMessage, errorCategory());
               promise.reject(std::move(error));
@@ -131,7 +143,7 @@ Promise<std::shared_ptr<Field>> readField(Stream stream,
             return;
           }
           case '*': {
-            auto len = parseArrayLength(buf.get(), n);
+            auto len = parseArrayLength(buf, n);
             if (len == -2) {
               std::error_code error(Errc::kBadMessage, errorCategory());
               promise.reject(std::move(error));
@@ -155,10 +167,11 @@ Promise<std::shared_ptr<Field>> readField(Stream stream,
             promise.reject(std::move(error));
         }
       })
-      .except([promise](size_t n, std::error_code error) {
+      .except([promise](boost::string_view line, std::error_code error) {
         promise.reject(std::move(error));
       });
 
+  sched::setWaitTag("redis.readField");
   return promise;
 }
 
@@ -173,6 +186,7 @@ Promise<void> writeField(Stream stream, std::shared_ptr<Field> field) {
         promise.reject(std::move(error));
       })
       .finally([bytes]() {});
+  sched::setWaitTag("redis.writeField");
   return promise;
 }
 
@@ -0,0 +1,274 @@
+#include "coro/scan.hpp"
+
+#include <cassert>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define CORO_SCAN_X86 1
+#endif
+
+namespace coro {
+namespace scan {
+
+static bool inSet(char chr, const char* set, size_t set_len) {
+  for (size_t i = 0; i < set_len; i++) {
+    if (chr == set[i]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static const char* findByteScalar(const char* begin, const char* end,
+                                  char chr) {
+  for (; begin < end; begin++) {
+    if (*begin == chr) {
+      return begin;
+    }
+  }
+  return end;
+}
+
+static const char* findAnyOfScalar(const char* begin, const char* end,
+                                   const char* set, size_t set_len) {
+  for (; begin < end; begin++) {
+    if (inSet(*begin, set, set_len)) {
+      return begin;
+    }
+  }
+  return end;
+}
+
+static const char* findCrlfScalar(const char* begin, const char* end) {
+  for (; end - begin >= 2; begin++) {
+    if (begin[0] == '\r' && begin[1] == '\n') {
+      return begin;
+    }
+  }
+  return end;
+}
+
+#ifdef CORO_SCAN_X86
+
+// x86_64 都支持 SSE2，无需检测。不足一个向量的尾部交给标量实现。
+
+static const char* findByteSse2(const char* begin, const char* end, char chr) {
+  __m128i needle = _mm_set1_epi8(chr);
+  for (; end - begin >= 16; begin += 16) {
+    __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+    int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(data, needle));
+    if (mask != 0) {
+      return begin + __builtin_ctz(mask);
+    }
+  }
+  return findByteScalar(begin, end, chr);
+}
+
+static const char* findAnyOfSse2(const char* begin, const char* end,
+                                 const char* set, size_t set_len) {
+  __m128i needles[kMaxSetSize];
+  for (size_t i = 0; i < set_len; i++) {
+    needles[i] = _mm_set1_epi8(set[i]);
+  }
+  for (; end - begin >= 16; begin += 16) {
+    __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+    __m128i hits = _mm_setzero_si128();
+    for (size_t i = 0; i < set_len; i++) {
+      hits = _mm_or_si128(hits, _mm_cmpeq_epi8(data, needles[i]));
+    }
+    int mask = _mm_movemask_epi8(hits);
+    if (mask != 0) {
+      return begin + __builtin_ctz(mask);
+    }
+  }
+  return findAnyOfScalar(begin, end, set, set_len);
+}
+
+static const char* findCrlfSse2(const char* begin, const char* end) {
+  __m128i cr = _mm_set1_epi8('\r');
+  __m128i lf = _mm_set1_epi8('\n');
+  // 同时加载 begin 和 begin + 1 处的向量，第 i 个字节为 \r
+  // 且第 i + 1 个字节为 \n 时找到 \r\n，因此每次需要 17 个字节。
+  for (; end - begin >= 17; begin += 16) {
+    __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+    __m128i next =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin + 1));
+    __m128i hits =
+        _mm_and_si128(_mm_cmpeq_epi8(data, cr), _mm_cmpeq_epi8(next, lf));
+    int mask = _mm_movemask_epi8(hits);
+    if (mask != 0) {
+      return begin + __builtin_ctz(mask);
+    }
+  }
+  return findCrlfScalar(begin, end);
+}
+
+// AVX2 的实现只在运行时检测到 CPU 支持 AVX2 时调用，因此编译时无需 -mavx2。
+// 尾部交给 SSE2 实现之前需要执行 vzeroupper，否则从 AVX 切换到非 VEX 编码的
+// SSE 指令会有很大的开销。不足一个向量的短数据直接使用 SSE2 实现。
+
+__attribute__((target("avx2"))) static const char* findByteAvx2(
+    const char* begin, const char* end, char chr) {
+  if (end - begin < 32) {
+    return findByteSse2(begin, end, chr);
+  }
+  __m256i needle = _mm256_set1_epi8(chr);
+  for (; end - begin >= 32; begin += 32) {
+    __m256i data =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+    unsigned mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(data, needle));
+    if (mask != 0) {
+      return begin + __builtin_ctz(mask);
+    }
+  }
+  _mm256_zeroupper();
+  return findByteSse2(begin, end, chr);
+}
+
+__attribute__((target("avx2"))) static const char* findAnyOfAvx2(
+    const char* begin, const char* end, const char* set, size_t set_len) {
+  if (end - begin < 32) {
+    return findAnyOfSse2(begin, end, set, set_len);
+  }
+  __m256i needles[kMaxSetSize];
+  for (size_t i = 0; i < set_len; i++) {
+    needles[i] = _mm256_set1_epi8(set[i]);
+  }
+  for (; end - begin >= 32; begin += 32) {
+    __m256i data =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+    __m256i hits = _mm256_setzero_si256();
+    for (size_t i = 0; i < set_len; i++) {
+      hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(data, needles[i]));
+    }
+    unsigned mask = _mm256_movemask_epi8(hits);
+    if (mask != 0) {
+      return begin + __builtin_ctz(mask);
+    }
+  }
+  _mm256_zeroupper();
+  return findAnyOfSse2(begin, end, set, set_len);
+}
+
+__attribute__((target("avx2"))) static const char* findCrlfAvx2(
+    const char* begin, const char* end) {
+  if (end - begin < 33) {
+    return findCrlfSse2(begin, end);
+  }
+  __m256i cr = _mm256_set1_epi8('\r');
+  __m256i lf = _mm256_set1_epi8('\n');
+  for (; end - begin >= 33; begin += 32) {
+    __m256i data =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+    __m256i next =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin + 1));
+    __m256i hits = _mm256_and_si256(_mm256_cmpeq_epi8(data, cr),
+                                    _mm256_cmpeq_epi8(next, lf));
+    unsigned mask = _mm256_movemask_epi8(hits);
+    if (mask != 0) {
+      return begin + __builtin_ctz(mask);
+    }
+  }
+  _mm256_zeroupper();
+  return findCrlfSse2(begin, end);
+}
+
+#else
+
+// 其他平台只有标量实现。
+#define findByteSse2 findByteScalar
+#define findAnyOfSse2 findAnyOfScalar
+#define findCrlfSse2 findCrlfScalar
+#define findByteAvx2 findByteScalar
+#define findAnyOfAvx2 findAnyOfScalar
+#define findCrlfAvx2 findCrlfScalar
+
+#endif  // CORO_SCAN_X86
+
+/**
+ * @brief 一个指令集的全部扫描函数。
+ */
+struct Impl {
+  Isa isa;
+  const char* (*find_byte)(const char*, const char*, char);
+  const char* (*find_any_of)(const char*, const char*, const char*, size_t);
+  const char* (*find_crlf)(const char*, const char*);
+};
+
+// 按 Isa 的值排列。
+static const Impl kImpls[] = {
+    {Isa::kScalar, findByteScalar, findAnyOfScalar, findCrlfScalar},
+    {Isa::kSse2, findByteSse2, findAnyOfSse2, findCrlfSse2},
+    {Isa::kAvx2, findByteAvx2, findAnyOfAvx2, findCrlfAvx2},
+};
+
+static bool supported(Isa isa) {
+  switch (isa) {
+    case Isa::kScalar:
+      return true;
+#ifdef CORO_SCAN_X86
+    case Isa::kSse2:
+      return true;
+    case Isa::kAvx2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2");
+#endif
+    default:
+      return false;
+  }
+}
+
+static const Impl* detect() {
+  Isa isa = Isa::kScalar;
+  if (supported(Isa::kAvx2)) {
+    isa = Isa::kAvx2;
+  } else if (supported(Isa::kSse2)) {
+    isa = Isa::kSse2;
+  }
+  return &kImpls[static_cast<int>(isa)];
+}
+
+// 当前使用的实现，第一次使用时检测。
+static const Impl*& current() {
+  static const Impl* impl = detect();
+  return impl;
+}
+
+Isa isa() { return current()->isa; }
+
+bool setIsa(Isa isa) {
+  if (!supported(isa)) {
+    return false;
+  }
+  current() = &kImpls[static_cast<int>(isa)];
+  return true;
+}
+
+const char* isaName(Isa isa) {
+  switch (isa) {
+    case Isa::kScalar:
+      return "scalar";
+    case Isa::kSse2:
+      return "sse2";
+    case Isa::kAvx2:
+      return "avx2";
+  }
+  return "unknown";
+}
+
+const char* findByte(const char* begin, const char* end, char chr) {
+  return current()->find_byte(begin, end, chr);
+}
+
+const char* findAnyOf(const char* begin, const char* end, const char* set,
+                      size_t set_len) {
+  assert(set_len <= kMaxSetSize);
+  return current()->find_any_of(begin, end, set, set_len);
+}
+
+const char* findCrlf(const char* begin, const char* end) {
+  return current()->find_crlf(begin, end);
+}
+
+}  // namespace scan
+}  // namespace coro
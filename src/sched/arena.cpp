@@ -0,0 +1,88 @@
+#include "coro/sched/arena.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace coro {
+namespace sched {
+
+Arena::~Arena() {
+  for (const Block& block : blocks_) {
+    delete[] block.data;
+  }
+}
+
+void* Arena::allocate(size_t size, size_t align) {
+  assert(align != 0 && (align & (align - 1)) == 0);
+  for (; block_index_ < blocks_.size(); block_index_++) {
+    const Block& block = blocks_[block_index_];
+    auto base = reinterpret_cast<uintptr_t>(block.data);
+    size_t begin = ((base + offset_ + align - 1) & ~(align - 1)) - base;
+    if (begin + size <= block.size) {
+      offset_ = begin + size;
+      live_++;
+      return block.data + begin;
+    }
+    offset_ = 0;
+  }
+
+  // 内存块数已达上限，例如有分配长期存活使 Arena 无法回退，
+  // 此时改用 operator new，避免 Arena 无限增长。
+  if (blocks_.size() >= max_blocks_ && align <= alignof(std::max_align_t)) {
+    fallback_live_++;
+    return ::operator new(size);
+  }
+
+  // 所有内存块都已用尽，分配一个新的内存块。
+  // new char[] 返回的内存满足基本对齐要求，更大的对齐要求需要额外空间。
+  size_t block_size = size + align;
+  if (block_size < block_size_) {
+    block_size = block_size_;
+  }
+  Block block{new char[block_size], block_size};
+  blocks_.push_back(block);
+  block_index_ = blocks_.size() - 1;
+  auto base = reinterpret_cast<uintptr_t>(block.data);
+  size_t begin = ((base + align - 1) & ~(align - 1)) - base;
+  offset_ = begin + size;
+  live_++;
+  return block.data + begin;
+}
+
+void Arena::deallocate(void* ptr) {
+  if (fallback_live_ > 0 && !owns(ptr)) {
+    fallback_live_--;
+    ::operator delete(ptr);
+    return;
+  }
+  assert(live_ > 0);
+  live_--;
+  if (live_ == 0) {
+    block_index_ = 0;
+    offset_ = 0;
+  }
+}
+
+bool Arena::owns(const void* ptr) const {
+  auto addr = reinterpret_cast<uintptr_t>(ptr);
+  for (const Block& block : blocks_) {
+    auto base = reinterpret_cast<uintptr_t>(block.data);
+    if (addr >= base && addr < base + block.size) {
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t Arena::capacity() const {
+  size_t result = 0;
+  for (const Block& block : blocks_) {
+    result += block.size;
+  }
+  return result;
+}
+
+}  // namespace sched
+}  // namespace coro
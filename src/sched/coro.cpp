@@ -1,5 +1,6 @@
 #include "coro/sched/coro.hpp"
 
+#include <atomic>
 #include <iostream>
 #include <utility>
 
@@ -22,6 +23,9 @@ void Coro::funcWrapper(transfer_t trans) {
     {
       auto cur = current();
       cur->func_();
+      // 协程局部存储中的值在协程自己的栈上析构。
+      cur->clearLocals();
+      cur->setArena(nullptr);
     }
     // 退出当前协程，协程对象由下一个协程析构。
     exit();
@@ -40,11 +44,14 @@ void Coro::funcWrapper(transfer_t trans) {
 
 Coro::Coro(Func func, size_t stack_size)
     : func_(std::move(func)), stack_size_(stack_size) {
-  void* stack = allocStack(stack_size);
-  fctx_ = make_fcontext(stack, stack_size, funcWrapper);
+  stack_ = allocStack(stack_size);
+  fctx_ = make_fcontext(stack_, stack_size, funcWrapper);
 }
 
 Coro::~Coro() {
+  // 协程可能在阻塞时被析构（没有任何对象持有它），需要将其从调度器中移除。
+  unlink();
+  clearLocals();
   if (stack_) {
     freeStack(stack_, stack_size_);
   }
@@ -63,5 +70,43 @@ void Coro::resume(Coro* prev) const {
   freeDead();
 }
 
+uint64_t Coro::nextId() {
+  static std::atomic<uint64_t> next_id(1);
+  return next_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+size_t Coro::allocLocalIndex() {
+  static std::atomic<size_t> next_index(0);
+  return next_index.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Coro::setLocal(size_t index, void* value, void (*deleter)(void*)) {
+  if (index >= locals_.size()) {
+    if (!value) {
+      return;
+    }
+    locals_.resize(index + 1);
+  }
+  LocalSlot old = locals_[index];
+  locals_[index].value = value;
+  locals_[index].deleter = deleter;
+  if (old.value) {
+    old.deleter(old.value);
+  }
+}
+
+void Coro::clearLocals() {
+  // 析构函数中可能再次访问协程局部存储，所以循环直至所有槽位都为空。
+  while (!locals_.empty()) {
+    std::vector<LocalSlot> locals;
+    locals.swap(locals_);
+    for (const LocalSlot& slot : locals) {
+      if (slot.value) {
+        slot.deleter(slot.value);
+      }
+    }
+  }
+}
+
 }  // namespace sched
 }  // namespace coro
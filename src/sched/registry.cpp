@@ -0,0 +1,137 @@
+#include "coro/sched/registry.hpp"
+
+#include <cxxabi.h>
+#include <execinfo.h>
+
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <utility>
+
+namespace coro {
+namespace sched {
+
+const char* stateName(CoroState state) {
+  switch (state) {
+    case CoroState::kReady:
+      return "ready";
+    case CoroState::kRunning:
+      return "running";
+    case CoroState::kBlocked:
+      return "blocked";
+    case CoroState::kDead:
+      return "dead";
+  }
+  return "unknown";
+}
+
+std::vector<void*> unwindStack(fcontext_t fctx, const void* stack_lo,
+                               const void* stack_hi, size_t max_depth) {
+  std::vector<void*> frames;
+#if defined(__x86_64__)
+  // jump_fcontext 在挂起的协程的栈上依次保存 mxcsr/x87 控制字、r12、r13、
+  // r14、r15、rbx、rbp 和返回地址，fctx 指向这块区域的起始位置。
+  auto lo = reinterpret_cast<uintptr_t>(stack_lo);
+  auto hi = reinterpret_cast<uintptr_t>(stack_hi);
+  auto saved = reinterpret_cast<uintptr_t>(fctx);
+  if (saved < lo || saved + 0x40 > hi) {
+    return frames;
+  }
+  auto rbp = *reinterpret_cast<const uintptr_t*>(saved + 0x30);
+  frames.push_back(*reinterpret_cast<void* const*>(saved + 0x38));
+
+  // 每个栈帧的 [rbp] 是上一个栈帧的 rbp，[rbp + 8] 是返回地址。
+  // 栈向低地址增长，所以上一个栈帧的 rbp 必须更大。
+  while (frames.size() < max_depth && rbp >= lo && rbp + 16 <= hi &&
+         rbp % sizeof(uintptr_t) == 0) {
+    auto frame = reinterpret_cast<const uintptr_t*>(rbp);
+    if (frame[1] == 0) {
+      break;
+    }
+    frames.push_back(reinterpret_cast<void*>(frame[1]));
+    if (frame[0] <= rbp) {
+      break;
+    }
+    rbp = frame[0];
+  }
+#endif
+  return frames;
+}
+
+/**
+ * @brief 解码 C++ 类型名。
+ * @param name 由 typeid(T).name() 返回的类型名。
+ * @return std::string 解码后的类型名，解码失败时返回原始类型名。
+ */
+static std::string demangle(const char* name) {
+  int status = 0;
+  char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+  if (status != 0 || !demangled) {
+    return name;
+  }
+  std::string result(demangled);
+  std::free(demangled);
+  return result;
+}
+
+void writeCoroDump(std::ostream& out, const std::vector<CoroInfo>& coros) {
+  // 按状态计数，并统计阻塞的协程等待的操作，便于在大量协程中找出卡住的位置。
+  std::map<CoroState, size_t> states;
+  std::map<std::string, size_t> blocked_on;
+  for (const CoroInfo& info : coros) {
+    states[info.state]++;
+    if (info.state == CoroState::kBlocked) {
+      blocked_on[info.blocked_on ? info.blocked_on : "unknown"]++;
+    }
+  }
+
+  out << coros.size() << " coroutines:";
+  const char* sep = " ";
+  for (const auto& state : states) {
+    out << sep << state.second << ' ' << stateName(state.first);
+    sep = ", ";
+  }
+  out << '\n';
+  for (const auto& tag : blocked_on) {
+    out << "  " << tag.second << " blocked on " << tag.first << '\n';
+  }
+
+  for (const CoroInfo& info : coros) {
+    auto age =
+        std::chrono::duration_cast<std::chrono::milliseconds>(info.age);
+    out << "\nCoroutine " << info.id << " [" << stateName(info.state);
+    if (info.state == CoroState::kBlocked && info.blocked_on) {
+      out << " on " << info.blocked_on;
+    }
+    out << "] age " << age.count() << " ms";
+    if (info.since_resume.count() >= 0) {
+      auto idle = std::chrono::duration_cast<std::chrono::milliseconds>(
+          info.since_resume);
+      out << ", last resumed " << idle.count() << " ms ago";
+    } else {
+      out << ", never resumed";
+    }
+    out << '\n';
+    if (info.spawn_site) {
+      out << "  spawned by " << demangle(info.spawn_site) << '\n';
+    }
+    if (!info.backtrace.empty()) {
+      auto size = static_cast<int>(info.backtrace.size());
+      char** symbols = backtrace_symbols(info.backtrace.data(), size);
+      for (int i = 0; i < size; i++) {
+        out << "  #" << i << ' ';
+        if (symbols) {
+          out << symbols[i];
+        } else {
+          out << info.backtrace[i];
+        }
+        out << '\n';
+      }
+      std::free(symbols);
+    }
+  }
+  out.flush();
+}
+
+}  // namespace sched
+}  // namespace coro
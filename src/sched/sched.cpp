@@ -1,5 +1,7 @@
 #include "coro/sched/sched.hpp"
 
+#include <utility>
+
 #include "coro/sched/scheduler.hpp"
 
 namespace coro {
@@ -10,8 +12,26 @@ static thread_local auto scheduler =
 
 boost::asio::io_context& io_context() { return scheduler->io_context(); }
 
+const char* ioBackend() {
+#if defined(BOOST_ASIO_HAS_IO_URING_AS_DEFAULT)
+  return "io_uring";
+#elif defined(BOOST_ASIO_HAS_EPOLL)
+  return "epoll";
+#elif defined(BOOST_ASIO_HAS_KQUEUE)
+  return "kqueue";
+#elif defined(BOOST_ASIO_HAS_DEV_POLL)
+  return "dev_poll";
+#elif defined(BOOST_ASIO_HAS_IOCP)
+  return "iocp";
+#else
+  return "select";
+#endif
+}
+
 std::shared_ptr<Coro> current() { return scheduler->current(); }
 
+Coro* currentPtr() { return scheduler->currentPtr(); }
+
 void schedule(std::shared_ptr<Coro> coro) { scheduler->schedule(coro); }
 
 void yield() { scheduler->yield(); }
@@ -24,5 +44,49 @@ void exit() { scheduler->exit(); }
 
 void freeDead() { scheduler->freeDead(); }
 
+void runWhenIdle(std::function<void()> task) {
+  scheduler->runWhenIdle(std::move(task));
+}
+
+BufferPool& bufferPool() { return scheduler->bufferPool(); }
+
+void startWatchdog(std::chrono::nanoseconds slice, StallHandler handler) {
+  scheduler->startWatchdog(slice, std::move(handler));
+}
+
+void stopWatchdog() { scheduler->stopWatchdog(); }
+
+void checkpoint() { scheduler->checkpoint(); }
+
+void monitorQueueDelay(std::chrono::nanoseconds window) {
+  scheduler->monitorQueueDelay(window);
+}
+
+void stopQueueDelay() { scheduler->stopQueueDelay(); }
+
+std::chrono::nanoseconds queueDelay() { return scheduler->queueDelay(); }
+
+Stats stats() { return scheduler->stats(); }
+
+Stats globalStats() { return Scheduler::globalStats(); }
+
+void trace(TraceEvent event, uint64_t coro_id, const char* tag) {
+  scheduler->trace(event, coro_id, tag);
+}
+
+void setWaitTag(const char* tag) { scheduler->currentPtr()->setWaitTag(tag); }
+
+std::vector<CoroInfo> coros(bool unwind) { return scheduler->coros(unwind); }
+
+void dumpCoros(std::ostream& out, bool unwind) {
+  writeCoroDump(out, scheduler->coros(unwind));
+}
+
+void dumpCorosOnSignal(int signo, bool unwind) {
+  scheduler->dumpCorosOnSignal(signo, unwind);
+}
+
+void dumpTrace(std::ostream& out) { Scheduler::dumpTrace(out); }
+
 }  // namespace sched
 }  // namespace coro
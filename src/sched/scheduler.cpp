@@ -1,86 +1,400 @@
 #include "coro/sched/scheduler.hpp"
 
+#include <pthread.h>
+
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <iostream>
+#include <mutex>
 #include <utility>
+#include <vector>
+
+#include "coro/probe.hpp"
 
 namespace coro {
 namespace sched {
 
 static constexpr size_t kIdleCoroStackSize = 1024 * 64;
+// 转储协程时回溯调用栈的最大深度。
+static constexpr size_t kMaxUnwindDepth = 32;
+
+// 所有线程的调度器，用于汇总统计数据和追踪记录。
+static std::mutex schedulers_mutex;
+static std::vector<Scheduler*> schedulers;
+
+/**
+ * @brief 增加只由一个线程修改的计数器，比 fetch_add 开销更小。
+ * @param counter 计数器。
+ * @param n 增量。
+ */
+static inline void bump(std::atomic<uint64_t>& counter, uint64_t n = 1) {
+  counter.store(counter.load(std::memory_order_relaxed) + n,
+                std::memory_order_relaxed);
+}
+
+/**
+ * @brief 获取 steady_clock 的当前时间。
+ * @return int64_t 当前时间，单位纳秒。
+ */
+static inline int64_t now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
 
 Scheduler::Scheduler()
     : current_(std::make_shared<Coro>()),
       idle_(std::make_shared<Coro>([this]() { idleFunc(); },
-                                   kIdleCoroStackSize)) {}
+                                   kIdleCoroStackSize)) {
+  for (std::atomic<uint64_t>& count : wakeup_latency_) {
+    count.store(0, std::memory_order_relaxed);
+  }
+  live_.prev = live_.next = &live_;
+  // 主协程也可能阻塞，同样需要被转储。
+  current_->state_ = CoroState::kRunning;
+  current_->create_time_ = current_->resume_time_ = now();
+  current_->linkBefore(&live_);
+  std::lock_guard<std::mutex> lock(schedulers_mutex);
+  schedulers.push_back(this);
+}
 
 Scheduler::~Scheduler() {
+  {
+    std::lock_guard<std::mutex> lock(schedulers_mutex);
+    schedulers.erase(std::find(schedulers.begin(), schedulers.end(), this));
+  }
+  delete trace_buffer_.load();
   if (!ready_queue_.empty() || blocked_count_) {
     std::cerr << "A thread can only exit when only the main coroutine is alive."
               << std::endl;
     std::terminate();
   }
+  // 在线程退出后仍被持有的协程析构时不能再访问链表头节点。
+  while (live_.next != &live_) {
+    live_.next->unlink();
+  }
 }
 
 void Scheduler::schedule(std::shared_ptr<Coro> coro) {
-  ready_queue_.push(coro);
+  bump(spawns_);
+  trace(TraceEvent::kSpawn, coro->id());
+  CORO_PROBE1(spawn, coro->id());
+  coro->state_ = CoroState::kReady;
+  coro->create_time_ = now();
+  coro->linkBefore(&live_);
+  pushReady(std::move(coro));
 }
 
 void Scheduler::yield() {
   if (ready_queue_.empty()) {
     return;
   }
-  ready_queue_.push(current_);
-  auto prev = current_.get();
-  current_ = ready_queue_.front();
-  ready_queue_.pop();
-  current_->resume(prev);
+  current_->state_ = CoroState::kReady;
+  pushReady(current_);
+  switchTo(popReady());
 }
 
 void Scheduler::block() {
-  blocked_count_++;
-  auto prev = current_.get();
+  bump(blocked_count_);
+  current_->state_ = CoroState::kBlocked;
+  current_->blocked_on_ = current_->wait_tag_;
+  current_->wait_tag_ = nullptr;
+  trace(TraceEvent::kBlock, current_->id(), current_->blocked_on_);
+  CORO_PROBE2(block, current_->id(), current_->blocked_on_);
   if (ready_queue_.empty()) {
-    current_ = idle_;
+    switchTo(idle_);
   } else {
-    current_ = ready_queue_.front();
-    ready_queue_.pop();
+    switchTo(popReady());
   }
-  current_->resume(prev);
 }
 
 void Scheduler::wakeUp(std::shared_ptr<Coro> coro) {
   assert(blocked_count_ > 0);
-  blocked_count_--;
-  ready_queue_.push(coro);
+  blocked_count_.store(blocked_count_.load(std::memory_order_relaxed) - 1,
+                       std::memory_order_relaxed);
+  coro->wakeup_time_ = now();
+  coro->state_ = CoroState::kReady;
+  trace(TraceEvent::kWakeUp, coro->id());
+  CORO_PROBE1(wakeup, coro->id());
+  pushReady(std::move(coro));
 }
 
 void Scheduler::exit() {
+  bump(exits_);
+  trace(TraceEvent::kExit, current_->id());
+  CORO_PROBE1(exit, current_->id());
+  current_->state_ = CoroState::kDead;
+  current_->unlink();
   dead_ = current_;
-  auto prev = current_.get();
   if (ready_queue_.empty()) {
-    current_ = idle_;
+    switchTo(idle_);
   } else {
-    current_ = ready_queue_.front();
-    ready_queue_.pop();
+    switchTo(popReady());
   }
-  current_->resume(prev);
 }
 
 void Scheduler::freeDead() { dead_.reset(); }
 
+void Scheduler::startWatchdog(std::chrono::nanoseconds slice,
+                              StallHandler handler) {
+  watchdog_.reset();
+  if (!handler) {
+    handler = printStallReport;
+  }
+  // 没有看门狗时切换不会更新正在运行的协程，启动前补上。
+  running_id_.store(current_ == idle_ ? 0 : current_->id(),
+                    std::memory_order_relaxed);
+  watchdog_.reset(new Watchdog(this, slice, std::move(handler)));
+}
+
+void Scheduler::stopWatchdog() {
+  watchdog_.reset();
+  // 此后切换不再清除超时标记，清除看门狗最后设置的标记。
+  slice_expired_.store(false, std::memory_order_relaxed);
+}
+
+std::vector<CoroInfo> Scheduler::coros(bool unwind) const {
+  // 主协程使用线程的栈，回溯时需要知道它的范围。
+  char* main_lo = nullptr;
+  char* main_hi = nullptr;
+  pthread_attr_t attr;
+  if (unwind && pthread_getattr_np(pthread_self(), &attr) == 0) {
+    void* addr = nullptr;
+    size_t size = 0;
+    if (pthread_attr_getstack(&attr, &addr, &size) == 0) {
+      main_lo = static_cast<char*>(addr);
+      main_hi = main_lo + size;
+    }
+    pthread_attr_destroy(&attr);
+  }
+
+  // 此后每次切换都记录恢复时间，之后的转储中 since_resume 是准确的。
+  track_resume_time_ = true;
+  int64_t time = now();
+  std::vector<CoroInfo> result;
+  for (CoroLink* link = live_.next; link != &live_; link = link->next) {
+    auto coro = static_cast<const Coro*>(link);
+    CoroInfo info{coro->id_,
+                  coro->state_,
+                  coro->spawn_site_,
+                  coro->blocked_on_,
+                  std::chrono::nanoseconds(time - coro->create_time_),
+                  std::chrono::nanoseconds(-1),
+                  {}};
+    if (coro->resume_time_ != 0) {
+      info.since_resume = std::chrono::nanoseconds(time - coro->resume_time_);
+    }
+    // 正在运行的协程的 fctx_ 已经失效，从未运行过的协程没有调用栈。
+    if (unwind && coro->state_ != CoroState::kRunning &&
+        coro->resume_time_ != 0) {
+      if (coro->stack_) {
+        info.backtrace = unwindStack(
+            coro->fctx_, static_cast<char*>(coro->stack_) - coro->stack_size_,
+            coro->stack_, kMaxUnwindDepth);
+      } else if (main_lo) {
+        info.backtrace =
+            unwindStack(coro->fctx_, main_lo, main_hi, kMaxUnwindDepth);
+      }
+    }
+    result.push_back(std::move(info));
+  }
+  return result;
+}
+
+void Scheduler::dumpCorosOnSignal(int signo, bool unwind) {
+  if (!dump_signals_) {
+    dump_signals_.reset(new boost::asio::signal_set(io_context_));
+  }
+  dump_signals_->add(signo);
+  struct Handler {
+    Scheduler* scheduler;
+    bool unwind;
+    void operator()(const boost::system::error_code& error, int signo) const {
+      if (error) {
+        return;
+      }
+      writeCoroDump(std::cerr, scheduler->coros(unwind));
+      scheduler->dump_signals_->async_wait(*this);
+    }
+  };
+  dump_signals_->cancel();
+  dump_signals_->async_wait(Handler{this, unwind});
+}
+
+void Scheduler::monitorQueueDelay(std::chrono::nanoseconds window) {
+  delay_window_ns_ = std::max<int64_t>(window.count(), kQueueDelayProbes);
+  if (delay_monitors_++ > 0) {
+    return;
+  }
+  delay_window_start_ = now();
+  delay_window_min_ = INT64_MAX;
+  delay_probe_.reset(new boost::asio::steady_timer(io_context_));
+  probeQueueDelay();
+}
+
+void Scheduler::stopQueueDelay() {
+  assert(delay_monitors_ > 0);
+  if (--delay_monitors_ > 0) {
+    return;
+  }
+  // 销毁定时器会取消等待中的探测，回调收到错误后直接返回。
+  delay_probe_epoch_++;
+  delay_probe_.reset();
+  delay_window_ns_ = 0;
+  queue_delay_ns_.store(0, std::memory_order_relaxed);
+}
+
+void Scheduler::probeQueueDelay() {
+  delay_probe_->expires_after(
+      std::chrono::nanoseconds(delay_window_ns_ / kQueueDelayProbes));
+  uint64_t epoch = delay_probe_epoch_;
+  delay_probe_->async_wait([this,
+                            epoch](const boost::system::error_code& error) {
+    // 停止时回调可能已经在等待执行，不会收到错误，需要比较停止的次数。
+    if (error || epoch != delay_probe_epoch_) {
+      return;
+    }
+    auto expiry = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        delay_probe_->expiry().time_since_epoch());
+    recordQueueDelay(std::max<int64_t>(now() - expiry.count(), 0));
+    probeQueueDelay();
+  });
+}
+
+void Scheduler::recordQueueDelay(int64_t delay) {
+  int64_t time = now();
+  // 本次探测属于下一个窗口，一次长时间的阻塞只会推迟一次探测，
+  // 因此不会使下一个窗口的最小值升高。
+  if (time - delay_window_start_ >= delay_window_ns_) {
+    int64_t min = delay_window_min_ == INT64_MAX ? delay : delay_window_min_;
+    queue_delay_ns_.store(min, std::memory_order_relaxed);
+    delay_window_start_ = time;
+    delay_window_min_ = delay;
+    return;
+  }
+  delay_window_min_ = std::min(delay_window_min_, delay);
+}
+
+Stats Scheduler::stats() const {
+  Stats result;
+  result.switches = switches_.load(std::memory_order_relaxed);
+  result.spawns = spawns_.load(std::memory_order_relaxed);
+  result.exits = exits_.load(std::memory_order_relaxed);
+  result.ready = ready_count_.load(std::memory_order_relaxed);
+  result.blocked = blocked_count_.load(std::memory_order_relaxed);
+  result.idle_time =
+      std::chrono::nanoseconds(idle_ns_.load(std::memory_order_relaxed));
+  for (size_t i = 0; i < kLatencyBuckets; i++) {
+    result.wakeup_latency[i] =
+        wakeup_latency_[i].load(std::memory_order_relaxed);
+  }
+  return result;
+}
+
+Stats Scheduler::globalStats() {
+  Stats result;
+  std::lock_guard<std::mutex> lock(schedulers_mutex);
+  for (const Scheduler* scheduler : schedulers) {
+    result += scheduler->stats();
+  }
+  return result;
+}
+
+void Scheduler::dumpTrace(std::ostream& out) {
+  std::vector<std::pair<uint64_t, std::vector<TraceRecord>>> threads;
+  {
+    std::lock_guard<std::mutex> lock(schedulers_mutex);
+    for (const Scheduler* scheduler : schedulers) {
+      TraceBuffer* buffer = scheduler->trace_buffer_.load();
+      if (buffer) {
+        threads.emplace_back(buffer->tid(), buffer->snapshot());
+      }
+    }
+  }
+  writeChromeTrace(out, threads);
+}
+
+TraceBuffer* Scheduler::traceBuffer() {
+  TraceBuffer* buffer = trace_buffer_.load(std::memory_order_relaxed);
+  if (!buffer) {
+    static std::atomic<uint64_t> next_tid(1);
+    buffer = new TraceBuffer(traceCapacity(), next_tid.fetch_add(1));
+    trace_buffer_.store(buffer);
+  }
+  return buffer;
+}
+
+void Scheduler::switchTo(std::shared_ptr<Coro> next) {
+  auto prev = current_.get();
+  current_ = std::move(next);
+  bump(switches_);
+  uint64_t running_id = current_ == idle_ ? 0 : current_->id();
+  // 只有看门狗读取正在运行的协程和设置时间片超时，没有看门狗时不必维护。
+  if (watchdog_) {
+    running_id_.store(running_id, std::memory_order_relaxed);
+    slice_expired_.store(false, std::memory_order_relaxed);
+  }
+  trace(TraceEvent::kResume, running_id);
+  CORO_PROBE1(resume, running_id);
+  current_->state_ = CoroState::kRunning;
+  // 上一次运行时设置但没有用上的等待标记已经过期。
+  current_->wait_tag_ = nullptr;
+  // 读取时钟有明显的开销，只在需要时读取：统计唤醒延迟、协程第一次运行，
+  // 或者已经有人转储过协程（需要准确的恢复时间）。
+  if (current_->wakeup_time_ != 0) {
+    int64_t time = now();
+    auto latency = static_cast<uint64_t>(time - current_->wakeup_time_);
+    bump(wakeup_latency_[latencyBucket(latency)]);
+    current_->wakeup_time_ = 0;
+    current_->resume_time_ = time;
+  } else if (track_resume_time_ || current_->resume_time_ == 0) {
+    current_->resume_time_ = now();
+  }
+  current_->resume(prev);
+}
+
+void Scheduler::pushReady(std::shared_ptr<Coro> coro) {
+  ready_queue_.push(std::move(coro));
+  bump(ready_count_);
+}
+
+std::shared_ptr<Coro> Scheduler::popReady() {
+  assert(!ready_queue_.empty());
+  auto coro = std::move(ready_queue_.front());
+  ready_queue_.pop();
+  ready_count_.store(ready_queue_.size(), std::memory_order_relaxed);
+  return coro;
+}
+
+void Scheduler::preempt() {
+  slice_expired_.store(false, std::memory_order_relaxed);
+  // 只有 idle 协程会处理 IO 事件，如果直接让出 CPU，
+  // 等待 IO 的协程将无法被唤醒。
+  io_context_.poll();
+  yield();
+}
+
 void Scheduler::idleFunc() {
   auto work_guard = boost::asio::make_work_guard(io_context_);
   for (;;) {
     assert(current_ == idle_);
     if (!ready_queue_.empty()) {
-      auto prev = current_.get();
-      current_ = ready_queue_.front();
-      ready_queue_.pop();
-      current_->resume(prev);
+      switchTo(popReady());
     }
     assert(current_ == idle_);
+    // 等待 IO 之前执行空闲任务。空闲任务可能唤醒协程，因此执行后重新检查就绪队列。
+    if (!idle_tasks_.empty()) {
+      std::vector<std::function<void()>> tasks;
+      tasks.swap(idle_tasks_);
+      for (auto& task : tasks) {
+        task();
+      }
+      continue;
+    }
+    int64_t begin = now();
     io_context_.run_one();
+    bump(idle_ns_, now() - begin);
   }
 }
 
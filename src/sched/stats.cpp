@@ -0,0 +1,48 @@
+#include "coro/sched/stats.hpp"
+
+namespace coro {
+namespace sched {
+
+Stats& Stats::operator+=(const Stats& other) {
+  switches += other.switches;
+  spawns += other.spawns;
+  exits += other.exits;
+  ready += other.ready;
+  blocked += other.blocked;
+  idle_time += other.idle_time;
+  for (size_t i = 0; i < kLatencyBuckets; i++) {
+    wakeup_latency[i] += other.wakeup_latency[i];
+  }
+  return *this;
+}
+
+std::chrono::nanoseconds Stats::wakeUpLatency(double quantile) const {
+  uint64_t total = 0;
+  for (uint64_t count : wakeup_latency) {
+    total += count;
+  }
+  if (total == 0) {
+    return std::chrono::nanoseconds(0);
+  }
+
+  auto rank = static_cast<uint64_t>(quantile * total);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kLatencyBuckets; i++) {
+    seen += wakeup_latency[i];
+    if (seen > rank || seen == total) {
+      return std::chrono::nanoseconds(uint64_t(2) << i);
+    }
+  }
+  return std::chrono::nanoseconds(uint64_t(2) << (kLatencyBuckets - 1));
+}
+
+size_t latencyBucket(uint64_t ns) {
+  if (ns < 2) {
+    return 0;
+  }
+  size_t bucket = 63 - __builtin_clzll(ns);
+  return bucket < kLatencyBuckets ? bucket : kLatencyBuckets - 1;
+}
+
+}  // namespace sched
+}  // namespace coro
@@ -0,0 +1,205 @@
+#include "coro/sched/trace.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <unordered_map>
+
+namespace coro {
+namespace sched {
+
+std::atomic<bool> trace_enabled(false);
+static std::atomic<size_t> trace_capacity(kDefaultTraceCapacity);
+
+TraceBuffer::TraceBuffer(size_t capacity, uint64_t tid) : tid_(tid), head_(0) {
+  size_t size = 1;
+  while (size < capacity) {
+    size <<= 1;
+  }
+  records_.reset(new TraceRecord[size]);
+  mask_ = size - 1;
+}
+
+void TraceBuffer::record(TraceEvent event, uint64_t coro_id, const char* tag) {
+  uint64_t head = head_.load(std::memory_order_relaxed);
+  TraceRecord& record = records_[head & mask_];
+  record.time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch())
+                    .count();
+  record.coro_id = coro_id;
+  record.tag = tag;
+  record.event = event;
+  head_.store(head + 1, std::memory_order_release);
+}
+
+std::vector<TraceRecord> TraceBuffer::snapshot() const {
+  uint64_t head = head_.load(std::memory_order_acquire);
+  uint64_t capacity = mask_ + 1;
+  uint64_t begin = head > capacity ? head - capacity : 0;
+  std::vector<TraceRecord> result;
+  result.reserve(head - begin);
+  for (uint64_t i = begin; i < head; i++) {
+    result.push_back(records_[i & mask_]);
+  }
+  // 读取期间被写入线程覆盖的记录不完整，将其丢弃。写入线程可能正在写入
+  // 第 new_head 条记录，它占用的槽位也要算作已覆盖。
+  uint64_t new_head = head_.load(std::memory_order_acquire);
+  if (new_head + 1 > begin + capacity) {
+    size_t overwritten = new_head + 1 - (begin + capacity);
+    if (overwritten > result.size()) {
+      overwritten = result.size();
+    }
+    result.erase(result.begin(), result.begin() + overwritten);
+  }
+  return result;
+}
+
+size_t traceCapacity() {
+  return trace_capacity.load(std::memory_order_relaxed);
+}
+
+void enableTrace(size_t capacity) {
+  trace_capacity.store(capacity, std::memory_order_relaxed);
+  trace_enabled.store(true, std::memory_order_relaxed);
+}
+
+void disableTrace() { trace_enabled.store(false, std::memory_order_relaxed); }
+
+static const char* eventName(TraceEvent event) {
+  switch (event) {
+    case TraceEvent::kSpawn:
+      return "spawn";
+    case TraceEvent::kResume:
+      return "resume";
+    case TraceEvent::kBlock:
+      return "block";
+    case TraceEvent::kWakeUp:
+      return "wakeUp";
+    case TraceEvent::kExit:
+      return "exit";
+    case TraceEvent::kIo:
+      return "io";
+    case TraceEvent::kUser:
+      return "user";
+    default:
+      return "unknown";
+  }
+}
+
+static void writeJsonString(std::ostream& out, const char* str) {
+  out << '"';
+  for (const char* cursor = str; *cursor; cursor++) {
+    char chr = *cursor;
+    if (chr == '"' || chr == '\\') {
+      out << '\\' << chr;
+    } else if (static_cast<unsigned char>(chr) < 0x20) {
+      out << ' ';
+    } else {
+      out << chr;
+    }
+  }
+  out << '"';
+}
+
+/**
+ * @brief 将纳秒输出为微秒，Chrome trace 的时间单位是微秒。
+ */
+static void writeMicros(std::ostream& out, int64_t ns) {
+  out << ns / 1000 << '.' << std::setw(3) << std::setfill('0') << ns % 1000
+      << std::setfill(' ');
+}
+
+/**
+ * @brief 输出一个 Chrome trace 事件的公共字段。
+ */
+static void writeEventHead(std::ostream& out, bool& first, const char* ph,
+                           uint64_t tid, int64_t time) {
+  out << (first ? "\n" : ",\n");
+  first = false;
+  out << "{\"ph\":\"" << ph << "\",\"pid\":1,\"tid\":" << tid << ",\"ts\":";
+  writeMicros(out, time);
+}
+
+static void writeCoroName(std::ostream& out, uint64_t coro_id) {
+  if (coro_id == 0) {
+    out << "\"idle\"";
+  } else {
+    out << "\"coro " << coro_id << '"';
+  }
+}
+
+void writeChromeTrace(
+    std::ostream& out,
+    const std::vector<std::pair<uint64_t, std::vector<TraceRecord>>>& threads) {
+  // 时间戳相对于最早的记录，避免浮点数精度问题。
+  int64_t origin = INT64_MAX;
+  for (const auto& thread : threads) {
+    if (!thread.second.empty() && thread.second.front().time < origin) {
+      origin = thread.second.front().time;
+    }
+  }
+
+  bool first = true;
+  uint64_t next_flow_id = 1;
+  out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  for (const auto& thread : threads) {
+    uint64_t tid = thread.first;
+    const std::vector<TraceRecord>& records = thread.second;
+    // 被唤醒但尚未恢复运行的协程对应的 flow ID。
+    std::unordered_map<uint64_t, uint64_t> pending_flows;
+
+    for (size_t i = 0; i < records.size(); i++) {
+      const TraceRecord& record = records[i];
+      int64_t time = record.time - origin;
+
+      if (record.event == TraceEvent::kResume) {
+        // 协程的运行区间从恢复运行开始，到下一次上下文切换结束。
+        int64_t end = time;
+        for (size_t j = i + 1; j < records.size(); j++) {
+          if (records[j].event == TraceEvent::kResume) {
+            end = records[j].time - origin;
+            break;
+          }
+        }
+        writeEventHead(out, first, "X", tid, time);
+        out << ",\"dur\":";
+        writeMicros(out, end - time);
+        out << ",\"name\":";
+        writeCoroName(out, record.coro_id);
+        out << ",\"args\":{\"coro\":" << record.coro_id << "}}";
+
+        auto iter = pending_flows.find(record.coro_id);
+        if (iter != pending_flows.end()) {
+          writeEventHead(out, first, "f", tid, time);
+          out << ",\"bp\":\"e\",\"cat\":\"wakeUp\",\"name\":\"wakeUp\","
+                 "\"id\":"
+              << iter->second << '}';
+          pending_flows.erase(iter);
+        }
+        continue;
+      }
+
+      writeEventHead(out, first, "i", tid, time);
+      out << ",\"s\":\"t\",\"name\":";
+      if (record.tag) {
+        writeJsonString(out, record.tag);
+      } else {
+        out << '"' << eventName(record.event) << '"';
+      }
+      out << ",\"cat\":\"" << eventName(record.event)
+          << "\",\"args\":{\"coro\":" << record.coro_id << "}}";
+
+      if (record.event == TraceEvent::kWakeUp) {
+        uint64_t flow_id = next_flow_id++;
+        pending_flows[record.coro_id] = flow_id;
+        writeEventHead(out, first, "s", tid, time);
+        out << ",\"cat\":\"wakeUp\",\"name\":\"wakeUp\",\"id\":" << flow_id
+            << '}';
+      }
+    }
+  }
+  out << "\n]}\n";
+}
+
+}  // namespace sched
+}  // namespace coro
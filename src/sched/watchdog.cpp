@@ -0,0 +1,171 @@
+#include "coro/sched/watchdog.hpp"
+
+#include <execinfo.h>
+#include <signal.h>
+
+#include <atomic>
+#include <iostream>
+#include <utility>
+
+#include "coro/sched/scheduler.hpp"
+
+namespace coro {
+namespace sched {
+
+// 用于在调度器线程上采集调用栈的信号。
+// SIGURG 的默认行为是忽略，即使在看门狗停止后到达也不会有副作用。
+static constexpr int kBacktraceSignal = SIGURG;
+static constexpr int kMaxFrames = 64;
+
+/**
+ * @brief 信号处理函数写入调用栈的位置。同一时刻只有一个看门狗在采集调用栈。
+ */
+struct BacktraceSlot {
+  void* frames[kMaxFrames];
+  std::atomic<int> depth;  // 调用栈深度，-1 表示尚未采集完成。
+};
+
+static BacktraceSlot backtrace_slot;
+static std::atomic<BacktraceSlot*> pending_slot(nullptr);
+static std::mutex capture_mutex;
+// 安装看门狗的信号处理函数之前的处理方式，不是看门狗发出的信号转交给它。
+static struct sigaction previous_action;
+
+static void onBacktraceSignal(int signo, siginfo_t* info, void* context) {
+  BacktraceSlot* slot = pending_slot.exchange(nullptr);
+  if (slot) {
+    int depth = backtrace(slot->frames, kMaxFrames);
+    slot->depth.store(depth, std::memory_order_release);
+    return;
+  }
+  if (previous_action.sa_flags & SA_SIGINFO) {
+    previous_action.sa_sigaction(signo, info, context);
+  } else if (previous_action.sa_handler != SIG_DFL &&
+             previous_action.sa_handler != SIG_IGN) {
+    previous_action.sa_handler(signo);
+  }
+}
+
+static void installSignalHandler() {
+  static std::once_flag once;
+  std::call_once(once, []() {
+    // backtrace 第一次调用时会加载 libgcc，不能在信号处理函数中进行。
+    void* frames[1];
+    backtrace(frames, 1);
+    struct sigaction action = {};
+    action.sa_sigaction = onBacktraceSignal;
+    action.sa_flags = SA_RESTART | SA_SIGINFO;
+    sigemptyset(&action.sa_mask);
+    sigaction(kBacktraceSignal, &action, &previous_action);
+  });
+}
+
+void printStallReport(const StallReport& report) {
+  auto ms =
+      std::chrono::duration_cast<std::chrono::milliseconds>(report.elapsed);
+  std::cerr << "Coroutine " << report.coro_id << " has been running for "
+            << ms.count() << " ms without yielding." << std::endl;
+  if (!report.backtrace.empty()) {
+    backtrace_symbols_fd(report.backtrace.data(),
+                         static_cast<int>(report.backtrace.size()), 2);
+  }
+}
+
+Watchdog::Watchdog(Scheduler* scheduler, std::chrono::nanoseconds slice,
+                   StallHandler handler)
+    : scheduler_(scheduler),
+      slice_(slice),
+      handler_(std::move(handler)),
+      target_(pthread_self()) {
+  installSignalHandler();
+  thread_ = std::thread([this]() { run(); });
+}
+
+Watchdog::~Watchdog() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopped_ = true;
+  }
+  cond_.notify_one();
+  thread_.join();
+}
+
+void Watchdog::run() {
+  auto interval = slice_ / 4;
+  if (interval < std::chrono::milliseconds(1)) {
+    interval = std::chrono::milliseconds(1);
+  }
+  uint64_t last_switches = scheduler_->switches();
+  auto last_change = std::chrono::steady_clock::now();
+  bool reported = false;
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stopped_) {
+    cond_.wait_for(lock, interval);
+    if (stopped_) {
+      break;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    uint64_t switches = scheduler_->switches();
+    if (switches != last_switches) {
+      last_switches = switches;
+      last_change = now;
+      reported = false;
+      continue;
+    }
+    // idle 协程在等待 IO，不属于超时。每次超时只报告一次。
+    uint64_t coro_id = scheduler_->runningId();
+    if (coro_id == 0 || reported || now - last_change < slice_) {
+      continue;
+    }
+    reported = true;
+
+    lock.unlock();
+    StallReport report{coro_id, now - last_change, captureBacktrace()};
+    // 采集调用栈期间协程可能已经让出 CPU，此时调用栈属于其他协程，
+    // 也不再需要让它让出 CPU。
+    if (scheduler_->switches() != last_switches) {
+      report.backtrace.clear();
+    } else {
+      scheduler_->expireSlice();
+      // 检查和设置之间协程可能恰好让出了 CPU，
+      // 此时标记属于下一个协程，需要撤销。
+      if (scheduler_->switches() != last_switches) {
+        scheduler_->clearSlice();
+      }
+    }
+    handler_(report);
+    lock.lock();
+  }
+}
+
+std::vector<void*> Watchdog::captureBacktrace() {
+  std::lock_guard<std::mutex> lock(capture_mutex);
+  backtrace_slot.depth.store(-1, std::memory_order_relaxed);
+  pending_slot.store(&backtrace_slot);
+  if (pthread_kill(target_, kBacktraceSignal) != 0) {
+    pending_slot.store(nullptr);
+    return {};
+  }
+
+  auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+  while (backtrace_slot.depth.load(std::memory_order_acquire) < 0) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      // 信号处理函数尚未取走 slot，放弃采集；
+      // 否则信号处理函数正在写入 slot，必须等待其完成。
+      if (pending_slot.exchange(nullptr)) {
+        return {};
+      }
+    }
+    std::this_thread::yield();
+  }
+
+  int depth = backtrace_slot.depth.load(std::memory_order_acquire);
+  return std::vector<void*>(backtrace_slot.frames,
+                            backtrace_slot.frames + depth);
+}
+
+}  // namespace sched
+}  // namespace coro
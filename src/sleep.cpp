@@ -19,6 +19,7 @@ Promise<void> milliSleep(size_t ms) {
       promise.resolve();
     }
   });
+  sched::setWaitTag("sleep");
   return promise;
 }
 
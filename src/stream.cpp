@@ -1,7 +1,11 @@
 #include "coro/stream.hpp"
 
+#include <algorithm>
 #include <cstring>
 
+#include "coro/scan.hpp"
+#include "coro/sched/sched.hpp"
+
 namespace coro {
 namespace impl {
 
@@ -36,44 +40,62 @@ Promise<size_t> Stream::readn(char* buf, size_t len) {
   return promise;
 }
 
-int64_t findChar(const char* buf, size_t len, char chr) {
-  for (int64_t i = 0; i < len; i++) {
-    if (buf[i] == chr) {
-      return i;
+Promise<size_t> Stream::read(char* buf, size_t len) {
+  if (read_begin_ == read_end_) {
+    return readSome(buf, len);
+  }
+  Promise<size_t> promise;
+  promise.resolve(copyFromBuf(buf, len));
+  return promise;
+}
+
+Promise<size_t> Stream::readv(const boost::asio::mutable_buffer* bufs,
+                              size_t count) {
+  if (read_begin_ == read_end_) {
+    return readSomev(bufs, count);
+  }
+  size_t n = 0;
+  for (size_t i = 0; i < count && read_begin_ != read_end_; i++) {
+    n += copyFromBuf(static_cast<char*>(bufs[i].data()), bufs[i].size());
+  }
+  Promise<size_t> promise;
+  promise.resolve(n);
+  return promise;
+}
+
+Promise<size_t> Stream::readSomev(const boost::asio::mutable_buffer* bufs,
+                                  size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    if (bufs[i].size() > 0) {
+      return readSome(static_cast<char*>(bufs[i].data()), bufs[i].size());
     }
   }
-  return -1;
+  Promise<size_t> promise;
+  promise.resolve(0);
+  return promise;
 }
 
-Promise<size_t> Stream::readline(char* buf, size_t len) {
+Promise<size_t> Stream::writev(const boost::asio::const_buffer* bufs,
+                               size_t count) {
   Promise<size_t> promise;
-  if (len == 0) {
+  // 跳过空的缓冲区。
+  for (; count > 0 && bufs->size() == 0; bufs++, count--) {
+  }
+  if (count == 0) {
     promise.resolve(0);
     return promise;
   }
 
-  read(buf, len)
-      .then([this, buf, promise, len](size_t n) {
-        // 读到 EOF 时返回。
-        if (n == 0) {
-          promise.resolve(0);
-          return;
-        }
-
-        int64_t newline_char_index = findChar(buf, n, '\n');
-        if (newline_char_index == -1) {
-          size_t nread = n;
-          readline(buf, len)
-              .then([promise, nread](size_t n) { promise.resolve(nread + n); })
-              .except([promise, nread](size_t n, std::error_code error) {
-                promise.reject(nread + n, std::move(error));
-              });
-        }
-
-        // 多余的字节追加到 read_buf_。
-        size_t line_len = newline_char_index + 1;
-        read_buf_.append(buf + line_len, n - line_len);
-        promise.resolve(line_len);
+  write(static_cast<const char*>(bufs->data()), bufs->size())
+      .then([this, bufs, count, promise](size_t n) {
+        size_t nwritten = n;
+        writev(bufs + 1, count - 1)
+            .then([promise, nwritten](size_t n) {
+              promise.resolve(nwritten + n);
+            })
+            .except([promise, nwritten](size_t n, std::error_code error) {
+              promise.reject(nwritten + n, std::move(error));
+            });
       })
       .except([promise](size_t n, std::error_code error) {
         promise.reject(n, std::move(error));
@@ -82,20 +104,196 @@ Promise<size_t> Stream::readline(char* buf, size_t len) {
   return promise;
 }
 
-size_t Stream::readFromBuf(char* buf, size_t len) {
-  if (read_buf_offset_ == read_buf_.size()) {
-    return 0;
+Promise<size_t> Stream::readline(char* buf, size_t len) {
+  Promise<size_t> promise;
+  if (len == 0) {
+    promise.resolve(0);
+    return promise;
+  }
+  readlineFromBuf(buf, len, 0, promise);
+  return promise;
+}
+
+Promise<boost::string_view> Stream::readUntil(char delim, size_t max) {
+  Promise<boost::string_view> promise;
+  if (max == 0) {
+    promise.resolve(boost::string_view());
+    return promise;
   }
-  size_t available = read_buf_.size() - read_buf_offset_;
-  if (available <= len) {
-    memcpy(buf, read_buf_.c_str() + read_buf_offset_, available);
-    read_buf_.resize(0);
-    read_buf_offset_ = 0;
-    return available;
+  readUntilFromBuf(delim, max, 0, promise);
+  return promise;
+}
+
+size_t Stream::scan(char delim, size_t max, size_t* scanned) const {
+  boost::string_view data = peek();
+  size_t limit = std::min(max, data.size());
+  if (*scanned < limit) {
+    const char* end = data.data() + limit;
+    const char* found = scan::findByte(data.data() + *scanned, end, delim);
+    if (found != end) {
+      return found - data.data() + 1;
+    }
+    *scanned = limit;
   }
-  memcpy(buf, read_buf_.c_str() + read_buf_offset_, len);
-  read_buf_offset_ += len;
-  return len;
+  return data.size() >= max ? max : 0;
+}
+
+void Stream::readlineFromBuf(char* buf, size_t len, size_t scanned,
+                             Promise<size_t> promise) {
+  for (;;) {
+    size_t n = scan('\n', len, &scanned);
+    if (n > 0) {
+      promise.resolve(copyFromBuf(buf, n));
+      return;
+    }
+
+    // 直接在回调中更新读缓冲区，比使用 fill() 少注册两个回调。
+    Promise<size_t> read = readIntoBuf();
+    if (!read.settled()) {
+      // 只在异步完成时从回调重新进入，同步完成的读取在循环中处理，
+      // 不会随着读取的次数加深调用栈。
+      read.then([this, buf, len, scanned, promise](size_t n) {
+            read_end_ += n;
+            // 读到 EOF 时返回剩余的数据。
+            if (n == 0) {
+              promise.resolve(copyFromBuf(buf, len));
+              return;
+            }
+            readlineFromBuf(buf, len, scanned, promise);
+          })
+          .except([this, promise](size_t n, std::error_code error) {
+            read_end_ += n;
+            promise.reject(0, std::move(error));
+          });
+      return;
+    }
+
+    std::error_code error;
+    n = read.await(&error);
+    read_end_ += n;
+    if (error) {
+      promise.reject(0, std::move(error));
+      return;
+    }
+    if (n == 0) {
+      promise.resolve(copyFromBuf(buf, len));
+      return;
+    }
+  }
+}
+
+void Stream::readUntilFromBuf(char delim, size_t max, size_t scanned,
+                              Promise<boost::string_view> promise) {
+  for (;;) {
+    size_t n = scan(delim, max, &scanned);
+    if (n > 0) {
+      promise.resolve(takeFromBuf(n));
+      return;
+    }
+
+    Promise<size_t> read = readIntoBuf();
+    if (!read.settled()) {
+      read.then([this, delim, max, scanned, promise](size_t n) {
+            read_end_ += n;
+            // 读到 EOF 时返回剩余的数据。
+            if (n == 0) {
+              promise.resolve(takeFromBuf(read_end_ - read_begin_));
+              return;
+            }
+            readUntilFromBuf(delim, max, scanned, promise);
+          })
+          .except([this, promise](size_t n, std::error_code error) {
+            read_end_ += n;
+            promise.reject(boost::string_view(), std::move(error));
+          });
+      return;
+    }
+
+    std::error_code error;
+    n = read.await(&error);
+    read_end_ += n;
+    if (error) {
+      promise.reject(boost::string_view(), std::move(error));
+      return;
+    }
+    if (n == 0) {
+      promise.resolve(takeFromBuf(read_end_ - read_begin_));
+      return;
+    }
+  }
+}
+
+Promise<size_t> Stream::fill() {
+  auto promise = readIntoBuf();
+  promise.then([this](size_t n) { read_end_ += n; })
+      .except([this](size_t n, std::error_code error) { read_end_ += n; });
+  return promise;
+}
+
+Promise<size_t> Stream::readIntoBuf() {
+  if (pooled_read_buf_ && read_begin_ == read_end_) {
+    return readIntoPooledBuf();
+  }
+
+  size_t used = read_end_ - read_begin_;
+  // 尾部空间不足一半时，将未消费的数据移动到头部。
+  if (read_begin_ > 0 && read_buf_size_ - read_end_ < read_buf_size_ / 2) {
+    memmove(read_buf_.get(), read_buf_.get() + read_begin_, used);
+    read_begin_ = 0;
+    read_end_ = used;
+  }
+  if (read_end_ == read_buf_size_) {
+    size_t size = std::max(read_buf_size_ * 2, kDefaultReadBufferSize);
+    // 从缓冲区池中取出，扩容后旧的缓冲区归还给池。
+    std::unique_ptr<char[]> buf = sched::bufferPool().acquire(size);
+    memcpy(buf.get(), read_buf_.get() + read_begin_, used);
+    releaseReadBuf();
+    read_buf_ = std::move(buf);
+    read_buf_size_ = size;
+    read_begin_ = 0;
+    read_end_ = used;
+  }
+
+  return readSome(read_buf_.get() + read_end_, read_buf_size_ - read_end_);
+}
+
+Promise<size_t> Stream::readIntoPooledBuf() {
+  // 等待数据期间不持有读缓冲区。
+  releaseReadBuf();
+  Promise<size_t> promise;
+  waitReadable()
+      .then([this, promise]() {
+        read_buf_ = sched::bufferPool().acquire(kDefaultReadBufferSize);
+        read_buf_size_ = kDefaultReadBufferSize;
+        readSome(read_buf_.get(), read_buf_size_)
+            .then([promise](size_t n) { promise.resolve(n); })
+            .except([promise](size_t n, std::error_code error) {
+              promise.reject(n, std::move(error));
+            });
+      })
+      .except([promise](std::error_code error) {
+        promise.reject(0, std::move(error));
+      });
+  return promise;
+}
+
+void Stream::releaseReadBuf() {
+  sched::bufferPool().release(std::move(read_buf_), read_buf_size_);
+  read_buf_size_ = 0;
+  read_begin_ = read_end_ = 0;
+}
+
+Promise<void> Stream::waitReadable() {
+  Promise<void> promise;
+  promise.resolve();
+  return promise;
+}
+
+size_t Stream::copyFromBuf(char* buf, size_t len) {
+  size_t n = std::min(len, read_end_ - read_begin_);
+  memcpy(buf, read_buf_.get() + read_begin_, n);
+  consume(n);
+  return n;
 }
 
 }  // namespace impl
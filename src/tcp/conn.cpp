@@ -1,62 +1,641 @@
 #include "coro/tcp/conn.hpp"
 
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/sendfile.h>
+#include <unistd.h>
+
+#include <algorithm>
 #include <boost/asio.hpp>
+#include <cerrno>
+#include <functional>
+#include <vector>
 
+#include "coro/probe.hpp"
 #include "coro/sched/sched.hpp"
 
 namespace coro {
 namespace tcp {
 namespace impl {
 
-Promise<size_t> Conn::read(char* buf, size_t len) {
+/**
+ * @brief 引用一个缓冲区数组的缓冲区序列，Asio 拷贝它时不会拷贝数组。
+ * @tparam Buffer boost::asio::const_buffer 或 boost::asio::mutable_buffer。
+ */
+template <typename Buffer>
+struct BufferRange {
+  using value_type = Buffer;
+  using const_iterator = const Buffer*;
+
+  const Buffer* begin() const { return first; }
+  const Buffer* end() const { return last; }
+
+  const Buffer* first;
+  const Buffer* last;
+};
+
+/**
+ * @brief 判断同步的 recv/send 是否因为套接字未就绪而失败。
+ */
+static bool wouldBlock(const boost::system::error_code& error) {
+  return error == boost::asio::error::would_block ||
+         error == boost::asio::error::try_again;
+}
+
+/**
+ * @brief 获取 errno 对应的错误码。
+ */
+static std::error_code lastError() {
+  return std::error_code(errno, std::system_category());
+}
+
+/**
+ * @brief 在作用域内屏蔽当前线程的 SIGPIPE。sendfile 和 splice 没有
+ * MSG_NOSIGNAL，对端关闭后写入套接字会产生 SIGPIPE，默认处理是终止进程。
+ * 析构时如果系统调用因 EPIPE 失败，丢弃它产生的 SIGPIPE，再恢复信号掩码。
+ * 应当只包含一次系统调用，析构时根据 errno 判断是否失败。
+ */
+class SigpipeGuard {
+ public:
+  SigpipeGuard() {
+    sigemptyset(&sigpipe_);
+    sigaddset(&sigpipe_, SIGPIPE);
+    // 已有未决的 SIGPIPE 时无法区分它是否由本次调用产生，不做处理。
+    sigset_t pending;
+    sigpending(&pending);
+    blocked_ = !sigismember(&pending, SIGPIPE);
+    if (blocked_) {
+      pthread_sigmask(SIG_BLOCK, &sigpipe_, &old_mask_);
+    }
+  }
+
+  ~SigpipeGuard() {
+    if (!blocked_) {
+      return;
+    }
+    int saved_errno = errno;
+    if (saved_errno == EPIPE) {
+      timespec zero = {0, 0};
+      sigtimedwait(&sigpipe_, nullptr, &zero);
+    }
+    pthread_sigmask(SIG_SETMASK, &old_mask_, nullptr);
+    errno = saved_errno;
+  }
+
+ private:
+  sigset_t sigpipe_;
+  sigset_t old_mask_;
+  bool blocked_;
+};
+
+/**
+ * @brief 不产生 SIGPIPE 的 sendfile(2)。
+ */
+static ssize_t sendFileNoSignal(int out_fd, int in_fd, off_t* offset,
+                                size_t count) {
+  SigpipeGuard guard;
+  return ::sendfile(out_fd, in_fd, offset, count);
+}
+
+/**
+ * @brief 从管道写入套接字、不产生 SIGPIPE 的 splice(2)。
+ */
+static ssize_t spliceNoSignal(int pipe_fd, int socket_fd, size_t len,
+                              unsigned flags) {
+  SigpipeGuard guard;
+  return ::splice(pipe_fd, nullptr, socket_fd, nullptr, len, flags);
+}
+
+// 每次 splice 最多读入管道的字节数，与管道的默认容量相同。
+static constexpr size_t kMaxSpliceSize = 64 * 1024;
+
+Conn::~Conn() { closePipe(); }
+
+void Conn::closePipe() {
+  for (int& fd : pipe_) {
+    if (fd >= 0) {
+      ::close(fd);
+      fd = -1;
+    }
+  }
+}
+
+bool Conn::tryInline() {
+  if (inline_streak_ >= kMaxInlineCompletions) {
+    inline_streak_ = 0;
+    return false;
+  }
+  if (!socket_.non_blocking()) {
+    boost::system::error_code error;
+    socket_.non_blocking(true, error);
+    if (error) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void Conn::finishWrite() {
+  writing_ = false;
+  // 按顺序开始排队的写入，直至其中一个需要异步完成。
+  while (!writing_ && !write_queue_.empty()) {
+    std::function<void()> task = std::move(write_queue_.front());
+    write_queue_.pop_front();
+    task();
+  }
+}
+
+Promise<size_t> Conn::readSome(char* buf, size_t len) {
   Promise<size_t> promise;
   if (len == 0) {
     promise.resolve(0);
     return promise;
   }
 
-  size_t n = Stream::readFromBuf(buf, len);
-  if (n > 0) {
-    promise.resolve(n);
-    return promise;
+  uint64_t coro_id = sched::currentPtr()->id();
+  // 已有异步读取时同步读取会先于它取走数据。
+  if (!reading_ && tryInline()) {
+    boost::system::error_code error;
+    size_t n = socket_.receive(boost::asio::mutable_buffer(buf, len), 0, error);
+    if (!wouldBlock(error)) {
+      inline_streak_++;
+      CORO_PROBE3(tcp_read, coro_id, n, error.value());
+      if (error) {
+        promise.reject(error);
+      } else {
+        promise.resolve(n);
+      }
+      return promise;
+    }
+    inline_streak_ = 0;
   }
 
+  reading_ = true;
+  std::weak_ptr<Conn> weak = shared_from_this();
   socket_.async_receive(boost::asio::mutable_buffer(buf, len),
-                        [promise](std::error_code error, size_t n) {
+                        [weak, promise, coro_id](std::error_code error,
+                                                 size_t n) {
+                          sched::trace(sched::TraceEvent::kIo, coro_id,
+                                       "tcp.read");
+                          CORO_PROBE3(tcp_read, coro_id, n, error.value());
+                          if (auto self = weak.lock()) {
+                            self->reading_ = false;
+                          }
                           if (error) {
                             promise.reject(std::move(error));
                           } else {
                             promise.resolve(n);
                           }
                         });
+  sched::setWaitTag("tcp.read");
   return promise;
 }
 
-Promise<size_t> Conn::write(const char* buf, size_t len) {
-  Promise<size_t> promise;
-  socket_.async_send(boost::asio::const_buffer(buf, len),
-                     [promise](std::error_code error, size_t n) {
+Promise<void> Conn::waitReadable() {
+  Promise<void> promise;
+  if (!reading_ && tryInline()) {
+    boost::system::error_code error;
+    // 出错时同样立即敲定，由随后的读取报告错误。
+    if (socket_.available(error) > 0 || error) {
+      promise.resolve();
+      return promise;
+    }
+  }
+
+  uint64_t coro_id = sched::currentPtr()->id();
+  socket_.async_wait(boost::asio::ip::tcp::socket::wait_read,
+                     [promise, coro_id](std::error_code error) {
+                       sched::trace(sched::TraceEvent::kIo, coro_id,
+                                    "tcp.wait");
                        if (error) {
                          promise.reject(std::move(error));
                        } else {
-                         promise.resolve(n);
+                         promise.resolve();
                        }
                      });
+  sched::setWaitTag("tcp.wait");
+  return promise;
+}
+
+Promise<size_t> Conn::write(const char* buf, size_t len) {
+  Promise<size_t> promise;
+  uint64_t coro_id = sched::currentPtr()->id();
+  // 之前的写入尚未完成，排队以免本次的数据插入它尚未发送的部分之前。
+  if (writeBusy()) {
+    auto self = shared_from_this();
+    write_queue_.push_back([self, buf, len, coro_id, promise]() {
+      self->startWrite(buf, len, coro_id, promise);
+    });
+    sched::setWaitTag("tcp.write");
+    return promise;
+  }
+  startWrite(buf, len, coro_id, promise);
+  if (writing_) {
+    sched::setWaitTag("tcp.write");
+  }
+  return promise;
+}
+
+void Conn::startWrite(const char* buf, size_t len, uint64_t coro_id,
+                      Promise<size_t> promise) {
+  size_t written = 0;
+  if (tryInline()) {
+    boost::system::error_code error;
+    written = socket_.send(boost::asio::const_buffer(buf, len), 0, error);
+    if (!error && written == len) {
+      inline_streak_++;
+      CORO_PROBE3(tcp_write, coro_id, len, 0);
+      promise.resolve(len);
+      return;
+    }
+    if (error && !wouldBlock(error)) {
+      inline_streak_++;
+      CORO_PROBE3(tcp_write, coro_id, 0, error.value());
+      promise.reject(0, error);
+      return;
+    }
+    // 发送缓冲区已满，剩余的数据异步写入。
+    if (error) {
+      written = 0;
+    }
+    inline_streak_ = 0;
+  }
+
+  writing_ = true;
+  std::weak_ptr<Conn> weak = shared_from_this();
+  boost::asio::async_write(
+      socket_, boost::asio::const_buffer(buf + written, len - written),
+      [weak, promise, coro_id, written](std::error_code error, size_t n) {
+        sched::trace(sched::TraceEvent::kIo, coro_id, "tcp.write");
+        CORO_PROBE3(tcp_write, coro_id, written + n, error.value());
+        if (error) {
+          promise.reject(written + n, std::move(error));
+        } else {
+          promise.resolve(written + n);
+        }
+        if (auto self = weak.lock()) {
+          self->finishWrite();
+        }
+      });
+}
+
+Promise<size_t> Conn::readSomev(const boost::asio::mutable_buffer* bufs,
+                                size_t count) {
+  Promise<size_t> promise;
+  uint64_t coro_id = sched::currentPtr()->id();
+  BufferRange<boost::asio::mutable_buffer> range{bufs, bufs + count};
+  if (!reading_ && tryInline()) {
+    boost::system::error_code error;
+    size_t n = socket_.receive(range, 0, error);
+    if (!wouldBlock(error)) {
+      inline_streak_++;
+      CORO_PROBE3(tcp_read, coro_id, n, error.value());
+      if (error) {
+        promise.reject(n, error);
+      } else {
+        promise.resolve(n);
+      }
+      return promise;
+    }
+    inline_streak_ = 0;
+  }
+
+  reading_ = true;
+  std::weak_ptr<Conn> weak = shared_from_this();
+  socket_.async_receive(range, [weak, promise, coro_id](std::error_code error,
+                                                        size_t n) {
+    sched::trace(sched::TraceEvent::kIo, coro_id, "tcp.read");
+    CORO_PROBE3(tcp_read, coro_id, n, error.value());
+    if (auto self = weak.lock()) {
+      self->reading_ = false;
+    }
+    if (error) {
+      promise.reject(n, std::move(error));
+    } else {
+      promise.resolve(n);
+    }
+  });
+  sched::setWaitTag("tcp.read");
+  return promise;
+}
+
+Promise<size_t> Conn::writev(const boost::asio::const_buffer* bufs,
+                             size_t count) {
+  Promise<size_t> promise;
+  uint64_t coro_id = sched::currentPtr()->id();
+  if (writeBusy()) {
+    auto self = shared_from_this();
+    write_queue_.push_back([self, bufs, count, coro_id, promise]() {
+      self->startWritev(bufs, count, coro_id, promise);
+    });
+    sched::setWaitTag("tcp.write");
+    return promise;
+  }
+  startWritev(bufs, count, coro_id, promise);
+  if (writing_) {
+    sched::setWaitTag("tcp.write");
+  }
   return promise;
 }
 
-Promise<std::shared_ptr<Conn>> connect(const std::string& host, uint16_t port) {
+void Conn::startWritev(const boost::asio::const_buffer* bufs, size_t count,
+                       uint64_t coro_id, Promise<size_t> promise) {
+  BufferRange<boost::asio::const_buffer> range{bufs, bufs + count};
+  size_t len = boost::asio::buffer_size(range);
+  size_t written = 0;
+  if (tryInline()) {
+    boost::system::error_code error;
+    written = socket_.send(range, 0, error);
+    if (!error && written == len) {
+      inline_streak_++;
+      CORO_PROBE3(tcp_write, coro_id, len, 0);
+      promise.resolve(len);
+      return;
+    }
+    if (error && !wouldBlock(error)) {
+      inline_streak_++;
+      CORO_PROBE3(tcp_write, coro_id, 0, error.value());
+      promise.reject(0, error);
+      return;
+    }
+    if (error) {
+      written = 0;
+    }
+    inline_streak_ = 0;
+  }
+
+  writing_ = true;
+  std::weak_ptr<Conn> weak = shared_from_this();
+  auto on_written = [weak, promise, coro_id, written](std::error_code error,
+                                                      size_t n) {
+    sched::trace(sched::TraceEvent::kIo, coro_id, "tcp.write");
+    CORO_PROBE3(tcp_write, coro_id, written + n, error.value());
+    if (error) {
+      promise.reject(written + n, std::move(error));
+    } else {
+      promise.resolve(written + n);
+    }
+    if (auto self = weak.lock()) {
+      self->finishWrite();
+    }
+  };
+  if (written == 0) {
+    boost::asio::async_write(socket_, range, std::move(on_written));
+    return;
+  }
+  // 发送缓冲区已满，跳过已经发送的部分，剩余的数据异步写入。
+  std::vector<boost::asio::const_buffer> rest;
+  for (const auto& buf : range) {
+    if (written >= buf.size()) {
+      written -= buf.size();
+      continue;
+    }
+    rest.push_back(buf + written);
+    written = 0;
+  }
+  boost::asio::async_write(socket_, rest, std::move(on_written));
+}
+
+Promise<size_t> Conn::sendFile(int fd, off_t offset, size_t len) {
+  Promise<size_t> promise;
+  boost::system::error_code error;
+  socket_.non_blocking(true, error);
+  if (error) {
+    promise.reject(0, error);
+    return promise;
+  }
+  uint64_t coro_id = sched::currentPtr()->id();
+  if (writeBusy()) {
+    auto self = shared_from_this();
+    write_queue_.push_back([self, fd, offset, len, coro_id, promise]() {
+      self->sendFileSome(fd, offset, len, 0, coro_id, promise);
+    });
+    sched::setWaitTag("tcp.sendfile");
+    return promise;
+  }
+  sendFileSome(fd, offset, len, 0, coro_id, promise);
+  return promise;
+}
+
+void Conn::sendFileSome(int fd, off_t offset, size_t len, size_t sent,
+                        uint64_t coro_id, Promise<size_t> promise) {
+  while (sent < len) {
+    ssize_t n =
+        sendFileNoSignal(socket_.native_handle(), fd, &offset, len - sent);
+    if (n > 0) {
+      sent += n;
+      continue;
+    }
+    // 文件提前结束。
+    if (n == 0) {
+      break;
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    if (errno != EAGAIN && errno != EWOULDBLOCK) {
+      CORO_PROBE3(tcp_write, coro_id, sent, errno);
+      promise.reject(sent, lastError());
+      if (writing_) {
+        finishWrite();
+      }
+      return;
+    }
+
+    // 发送缓冲区已满，等待套接字可写，期间其他写入排队。
+    writing_ = true;
+    auto self = shared_from_this();
+    socket_.async_wait(
+        boost::asio::ip::tcp::socket::wait_write,
+        [self, fd, offset, len, sent, promise,
+         coro_id](std::error_code error) {
+          sched::trace(sched::TraceEvent::kIo, coro_id, "tcp.sendfile");
+          if (error) {
+            promise.reject(sent, std::move(error));
+            self->finishWrite();
+            return;
+          }
+          self->sendFileSome(fd, offset, len, sent, coro_id, promise);
+        });
+    sched::setWaitTag("tcp.sendfile");
+    return;
+  }
+  CORO_PROBE3(tcp_write, coro_id, sent, 0);
+  promise.resolve(sent);
+  if (writing_) {
+    finishWrite();
+  }
+}
+
+Promise<size_t> Conn::splice(std::shared_ptr<Conn> src, size_t len) {
+  Promise<size_t> promise;
+  if (len == 0) {
+    promise.resolve(0);
+    return promise;
+  }
+  // src 的读缓冲区中的数据已经不在套接字中，先用 write 转发。
+  boost::string_view buffered = src->peek();
+  if (!buffered.empty()) {
+    size_t n = std::min(len, buffered.size());
+    write(buffered.data(), n)
+        .then([src, promise](size_t n) {
+          src->consume(n);
+          promise.resolve(n);
+        })
+        .except([promise](size_t n, std::error_code error) {
+          promise.reject(n, std::move(error));
+        });
+    return promise;
+  }
+
+  boost::system::error_code error;
+  socket_.non_blocking(true, error);
+  if (!error) {
+    src->socket_.non_blocking(true, error);
+  }
+  if (error) {
+    promise.reject(0, error);
+    return promise;
+  }
+  if (pipe_[0] < 0 && ::pipe2(pipe_, O_NONBLOCK | O_CLOEXEC) != 0) {
+    promise.reject(0, lastError());
+    return promise;
+  }
+  spliceFromSource(std::move(src), len, sched::currentPtr()->id(), promise);
+  return promise;
+}
+
+void Conn::spliceToSocket(std::shared_ptr<Conn> src, size_t len,
+                          size_t in_pipe, size_t forwarded, uint64_t coro_id,
+                          Promise<size_t> promise) {
+  unsigned flags = SPLICE_F_MOVE | SPLICE_F_NONBLOCK;
+  while (in_pipe > 0) {
+    ssize_t n =
+        spliceNoSignal(pipe_[0], socket_.native_handle(), in_pipe, flags);
+    if (n > 0) {
+      in_pipe -= n;
+      forwarded += n;
+      continue;
+    }
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      // 等待套接字可写，期间其他写入排队。
+      writing_ = true;
+      auto self = shared_from_this();
+      socket_.async_wait(
+          boost::asio::ip::tcp::socket::wait_write,
+          [self, src, len, in_pipe, forwarded, promise,
+           coro_id](std::error_code error) {
+            sched::trace(sched::TraceEvent::kIo, coro_id, "tcp.splice");
+            if (error) {
+              self->closePipe();
+              promise.reject(forwarded, std::move(error));
+              self->finishWrite();
+              return;
+            }
+            self->spliceToSocket(src, len, in_pipe, forwarded, coro_id,
+                                 promise);
+          });
+      sched::setWaitTag("tcp.splice");
+      return;
+    }
+    std::error_code error =
+        n < 0 ? lastError() : std::make_error_code(std::errc::io_error);
+    closePipe();
+    promise.reject(forwarded, error);
+    if (writing_) {
+      finishWrite();
+    }
+    return;
+  }
+  CORO_PROBE3(tcp_write, coro_id, forwarded, 0);
+  promise.resolve(forwarded);
+  if (writing_) {
+    finishWrite();
+  }
+}
+
+void Conn::spliceFromSource(std::shared_ptr<Conn> src, size_t len,
+                            uint64_t coro_id, Promise<size_t> promise) {
+  unsigned flags = SPLICE_F_MOVE | SPLICE_F_NONBLOCK;
+  for (;;) {
+    ssize_t n = ::splice(src->socket_.native_handle(), nullptr, pipe_[1],
+                         nullptr, std::min(len, kMaxSpliceSize), flags);
+    if (n > 0) {
+      // 管道中的数据与其他写入一样按顺序写入本连接。
+      if (writeBusy()) {
+        auto self = shared_from_this();
+        write_queue_.push_back([self, src, len, n, coro_id, promise]() {
+          self->spliceToSocket(src, len, n, 0, coro_id, promise);
+        });
+        return;
+      }
+      spliceToSocket(std::move(src), len, n, 0, coro_id, promise);
+      return;
+    }
+    // src 读取到 EOF。
+    if (n == 0) {
+      promise.resolve(0);
+      return;
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    if (errno != EAGAIN && errno != EWOULDBLOCK) {
+      promise.reject(0, lastError());
+      return;
+    }
+
+    auto self = shared_from_this();
+    src->socket_.async_wait(
+        boost::asio::ip::tcp::socket::wait_read,
+        [self, src, len, promise, coro_id](std::error_code error) {
+          sched::trace(sched::TraceEvent::kIo, coro_id, "tcp.splice");
+          if (error) {
+            promise.reject(0, std::move(error));
+            return;
+          }
+          self->spliceFromSource(src, len, coro_id, promise);
+        });
+    sched::setWaitTag("tcp.splice");
+    return;
+  }
+}
+
+Promise<std::shared_ptr<Conn>> connect(const std::string& host, uint16_t port,
+                                       const SocketOptions& options) {
   Promise<std::shared_ptr<Conn>> promise;
   auto conn = std::make_shared<Conn>(sched::io_context());
   boost::asio::ip::tcp ::endpoint endpoint(
       boost::asio::ip::address::from_string(host), port);
-  conn->socket_.async_connect(endpoint, [conn, promise](std::error_code error) {
+  // 缓冲区大小、TCP_FASTOPEN_CONNECT 等选项必须在发起连接之前设置，
+  // 因此先打开套接字。
+  boost::system::error_code error;
+  conn->socket_.open(endpoint.protocol(), error);
+  if (error) {
+    promise.reject(error);
+    return promise;
+  }
+  std::error_code err = applySocketOptions(conn->socket_.native_handle(),
+                                           options, SocketRole::kConnect);
+  if (err) {
+    promise.reject(err);
+    return promise;
+  }
+  uint64_t coro_id = sched::currentPtr()->id();
+  conn->socket_.async_connect(endpoint, [conn, promise,
+                                         coro_id](std::error_code error) {
+    sched::trace(sched::TraceEvent::kIo, coro_id, "tcp.connect");
     if (error) {
       promise.reject(std::move(error));
     } else {
       promise.resolve(conn);
     }
   });
+  sched::setWaitTag("tcp.connect");
   return promise;
 }
 
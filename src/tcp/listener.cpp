@@ -1,7 +1,18 @@
 #include "coro/tcp/listener.hpp"
 
+#include <linux/filter.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <utility>
+
 #include "coro/exception.hpp"
 #include "coro/sched/sched.hpp"
+#include "coro/sleep.hpp"
+#include "coro/spawn.hpp"
 
 namespace coro {
 namespace tcp {
@@ -10,49 +21,336 @@ namespace impl {
 Promise<std::shared_ptr<Conn>> Listener::accept() {
   Promise<std::shared_ptr<Conn>> promise;
   auto conn = std::make_shared<Conn>(sched::io_context());
-  acceptor_.async_accept(conn->socket_, [conn, promise](std::error_code error) {
+  uint64_t coro_id = sched::currentPtr()->id();
+  SocketOptions options = options_;
+  acceptor_.async_accept(conn->socket_, [conn, promise, coro_id,
+                                         options](std::error_code error) {
+    sched::trace(sched::TraceEvent::kIo, coro_id, "tcp.accept");
+    if (!error) {
+      error = applySocketOptions(conn->socket_.native_handle(), options,
+                                 SocketRole::kAccepted);
+    }
     if (error) {
       promise.reject(std::move(error));
     } else {
       promise.resolve(conn);
     }
   });
+  sched::setWaitTag("tcp.accept");
   return promise;
 }
 
-std::shared_ptr<Listener> listen(const std::string& host, uint16_t port,
-                                 std::error_code* error) {
-  boost::asio::ip::tcp ::endpoint endpoint(
-      boost::asio::ip::address::from_string(host), port);
-  boost::asio::ip::tcp::acceptor acceptor(sched::io_context());
-  boost::system::error_code err;
-
-  acceptor.open(endpoint.protocol(), err);
-  if (err) {
+Promise<std::vector<std::shared_ptr<Conn>>> Listener::acceptBatch(size_t max) {
+  Promise<std::vector<std::shared_ptr<Conn>>> promise;
+  if (max == 0) {
+    promise.resolve(std::vector<std::shared_ptr<Conn>>());
+    return promise;
+  }
+  // accept4 直接作用于监听套接字，必须是非阻塞的。
+  if (!acceptor_.non_blocking()) {
+    boost::system::error_code error;
+    acceptor_.non_blocking(true, error);
     if (error) {
-      *error = err;
+      promise.reject(error);
+      return promise;
     }
-    return nullptr;
   }
+  acceptBatchSome(max, sched::currentPtr()->id(), promise);
+  return promise;
+}
 
-  boost::asio::socket_base::reuse_address option(true);
-  acceptor.set_option(option, err);
-  if (err) {
+void Listener::acceptBatchSome(
+    size_t max, uint64_t coro_id,
+    Promise<std::vector<std::shared_ptr<Conn>>> promise) {
+  std::vector<std::shared_ptr<Conn>> conns;
+  std::error_code error = acceptReady(max, &conns);
+  // 已经接受到连接时先返回它们，错误留给下一次调用。
+  if (!conns.empty()) {
+    promise.resolve(std::move(conns));
+    return;
+  }
+  if (error) {
+    promise.reject(error);
+    return;
+  }
+
+  auto self = shared_from_this();
+  acceptor_.async_wait(
+      boost::asio::ip::tcp::acceptor::wait_read,
+      [self, max, coro_id, promise](std::error_code error) {
+        sched::trace(sched::TraceEvent::kIo, coro_id, "tcp.accept");
+        if (error) {
+          promise.reject(std::move(error));
+          return;
+        }
+        self->acceptBatchSome(max, coro_id, promise);
+      });
+  sched::setWaitTag("tcp.accept");
+}
+
+std::error_code Listener::acceptReady(
+    size_t max, std::vector<std::shared_ptr<Conn>>* conns) {
+  boost::system::error_code error;
+  auto protocol = acceptor_.local_endpoint(error).protocol();
+  if (error) {
+    return error;
+  }
+  while (conns->size() < max) {
+    int fd = ::accept4(acceptor_.native_handle(), nullptr, nullptr,
+                       SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      // 在被接受之前已经断开的连接直接跳过。
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        return std::error_code();
+      }
+      return std::error_code(errno, std::system_category());
+    }
+    std::error_code err =
+        applySocketOptions(fd, options_, SocketRole::kAccepted);
+    if (err) {
+      ::close(fd);
+      return err;
+    }
+    auto conn = std::make_shared<Conn>(sched::io_context());
+    conn->socket_.assign(protocol, fd, error);
     if (error) {
-      *error = err;
+      ::close(fd);
+      return error;
+    }
+    conns->push_back(std::move(conn));
+  }
+  return std::error_code();
+}
+
+// 因资源不足接受连接失败时，serve 重试前等待的最短和最长时间（毫秒）。
+static constexpr size_t kMinAcceptBackoff = 1;
+static constexpr size_t kMaxAcceptBackoff = 1000;
+
+/**
+ * @brief 判断接受连接的错误是否是暂时的资源不足。
+ * 此时连接留在监听队列中，释放资源后可以重新接受。
+ * @param error 错误码。
+ * @return true 资源不足，稍后重试。
+ * @return false 其他错误。
+ */
+static bool isTransientAcceptError(const std::error_code& error) {
+  return error == std::errc::too_many_files_open ||
+         error == std::errc::too_many_files_open_in_system ||
+         error == std::errc::no_buffer_space ||
+         error == std::errc::not_enough_memory;
+}
+
+/**
+ * @brief 在作用域内测量当前线程的调度器的调度延迟。
+ */
+class QueueDelayMonitor {
+ public:
+  /**
+   * @brief 构造 QueueDelayMonitor。
+   * @param enabled 是否测量。
+   * @param window 窗口长度。
+   */
+  QueueDelayMonitor(bool enabled, std::chrono::nanoseconds window)
+      : enabled_(enabled) {
+    if (enabled_) {
+      sched::monitorQueueDelay(window);
+    }
+  }
+
+  QueueDelayMonitor(const QueueDelayMonitor&) = delete;
+  QueueDelayMonitor& operator=(const QueueDelayMonitor&) = delete;
+
+  ~QueueDelayMonitor() {
+    if (enabled_) {
+      sched::stopQueueDelay();
     }
-    return nullptr;
   }
 
-  acceptor.bind(endpoint, err);
+ private:
+  bool enabled_;
+};
+
+Promise<void> Listener::serve(
+    std::function<void(std::shared_ptr<Conn>)> handler, size_t batch) {
+  ServeOptions options;
+  options.batch = batch;
+  return serve(std::move(handler), options);
+}
+
+Promise<void> Listener::serve(
+    std::function<void(std::shared_ptr<Conn>)> handler,
+    const ServeOptions& options) {
+  auto self = shared_from_this();
+  return spawn([self, handler, options]() {
+    bool shedding = options.shed_target.count() > 0;
+    // serve 结束（包括抛出异常）时停止测量调度延迟。
+    QueueDelayMonitor monitor(shedding, options.shed_interval);
+    size_t backoff = kMinAcceptBackoff;
+    for (;;) {
+      // batch 为 0 时 acceptBatch 不会接受任何连接，至少接受一个。
+      size_t batch = std::max<size_t>(options.batch, 1);
+      if (options.max_conns > 0) {
+        // 达到上限时不再接受连接，新连接在监听队列中等待，
+        // 队列满后由内核拒绝，而不是无限制地创建协程。
+        while (self->active_conns_ >= options.max_conns) {
+          if (!self->acceptor_.is_open()) {
+            return;
+          }
+          Promise<void> slot;
+          self->slot_waiters_.push_back(slot);
+          slot.await();
+        }
+        batch = std::min(batch, options.max_conns - self->active_conns_);
+      }
+
+      std::error_code error;
+      auto conns = self->acceptBatch(batch).await(&error);
+      if (error) {
+        // 监听器被关闭时正常结束。
+        if (!self->acceptor_.is_open()) {
+          return;
+        }
+        // 文件描述符或内存耗尽时监听套接字始终可读，立即重试只会空转。
+        // 等待已有的连接释放资源，每次失败将等待时间加倍。
+        if (isTransientAcceptError(error)) {
+          milliSleep(backoff).await();
+          backoff = std::min(backoff * 2, kMaxAcceptBackoff);
+          continue;
+        }
+        throw Exception(error);
+      }
+      backoff = kMinAcceptBackoff;
+
+      // 调度延迟持续超过目标时，新连接只会进一步拖慢已有的连接，直接丢弃。
+      if (shedding && sched::queueDelay() > options.shed_target) {
+        self->shed_conns_ += conns.size();
+        for (auto& conn : conns) {
+          if (options.shed_handler &&
+              self->shed_handlers_ < options.max_shed_handlers) {
+            auto shed_handler = options.shed_handler;
+            self->shed_handlers_++;
+            spawn([shed_handler, conn]() { shed_handler(conn); })
+                .finally([self]() { self->shed_handlers_--; });
+          } else {
+            conn->close();
+          }
+        }
+        continue;
+      }
+      for (auto& conn : conns) {
+        self->active_conns_++;
+        spawn([handler, conn]() { handler(conn); }).finally([self]() {
+          self->releaseConn();
+        });
+      }
+    }
+  });
+}
+
+void Listener::close() {
+  boost::system::error_code error;
+  acceptor_.close(error);
+  wakeSlotWaiters();
+}
+
+void Listener::releaseConn() {
+  assert(active_conns_ > 0);
+  active_conns_--;
+  wakeSlotWaiters();
+}
+
+void Listener::wakeSlotWaiters() {
+  // 先交换再敲定，被唤醒的 serve 可能再次等待。
+  std::vector<Promise<void>> waiters;
+  waiters.swap(slot_waiters_);
+  for (auto& waiter : waiters) {
+    waiter.resolve();
+  }
+}
+
+/**
+ * @brief 为 SO_REUSEPORT 组附加按 CPU 选择监听套接字的 CBPF 程序。
+ * @param fd 组中的任一监听套接字。
+ * @param group_size 组中监听套接字的个数。
+ * @return std::error_code 错误码。
+ */
+static std::error_code attachCpuSteering(int fd, unsigned group_size) {
+  struct sock_filter code[] = {
+      // A = 处理该数据包的 CPU 编号。
+      {BPF_LD | BPF_W | BPF_ABS, 0, 0,
+       static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU)},
+      // A = A % group_size。
+      {BPF_ALU | BPF_MOD | BPF_K, 0, 0, group_size},
+      // 返回 A，即组中监听套接字的下标。
+      {BPF_RET | BPF_A, 0, 0, 0},
+  };
+  struct sock_fprog prog = {sizeof(code) / sizeof(code[0]), code};
+  if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog,
+                 sizeof(prog)) != 0) {
+    return std::error_code(errno, std::system_category());
+  }
+  return std::error_code();
+}
+
+/**
+ * @brief 按照选项打开、绑定并监听 acceptor。
+ * @return std::error_code 错误码。
+ */
+static std::error_code openAcceptor(
+    boost::asio::ip::tcp::acceptor* acceptor,
+    const boost::asio::ip::tcp::endpoint& endpoint,
+    const ListenOptions& options) {
+  boost::system::error_code error;
+  acceptor->open(endpoint.protocol(), error);
+  if (error) {
+    return error;
+  }
+  acceptor->set_option(
+      boost::asio::socket_base::reuse_address(options.reuse_address), error);
+  if (error) {
+    return error;
+  }
+  // 被接受的连接继承监听套接字的选项，SO_RCVBUF 等选项必须在握手之前设置。
+  std::error_code err = applySocketOptions(
+      acceptor->native_handle(), options.socket, SocketRole::kListener);
   if (err) {
+    return err;
+  }
+  if (options.reuse_port) {
+    using ReusePort =
+        boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+    acceptor->set_option(ReusePort(true), error);
     if (error) {
-      *error = err;
+      return error;
     }
-    return nullptr;
   }
+  acceptor->bind(endpoint, error);
+  if (error) {
+    return error;
+  }
+  acceptor->listen(options.backlog, error);
+  if (error) {
+    return error;
+  }
+  // 监听之后套接字才加入 SO_REUSEPORT 组，在此之前附加程序会为它单独创建一个组，
+  // 导致同一端口上的其他监听套接字无法加入。
+  if (options.cpu_steering_group > 0) {
+    return attachCpuSteering(acceptor->native_handle(),
+                             options.cpu_steering_group);
+  }
+  return std::error_code();
+}
 
-  acceptor.listen(boost::asio::socket_base::max_listen_connections, err);
+std::shared_ptr<Listener> listen(const std::string& host, uint16_t port,
+                                 const ListenOptions& options,
+                                 std::error_code* error) {
+  boost::asio::ip::tcp ::endpoint endpoint(
+      boost::asio::ip::address::from_string(host), port);
+  boost::asio::ip::tcp::acceptor acceptor(sched::io_context());
+  std::error_code err = openAcceptor(&acceptor, endpoint, options);
   if (err) {
     if (error) {
       *error = err;
@@ -60,19 +358,25 @@ std::shared_ptr<Listener> listen(const std::string& host, uint16_t port,
     return nullptr;
   }
 
-  auto listener = std::make_shared<Listener>(std::move(acceptor));
+  auto listener =
+      std::make_shared<Listener>(std::move(acceptor), options.socket);
   return listener;
 }
 
-std::shared_ptr<Listener> listen(const std::string& host, uint16_t port) {
+std::shared_ptr<Listener> listen(const std::string& host, uint16_t port,
+                                 const ListenOptions& options) {
   std::error_code error;
-  auto listener = listen(host, port, &error);
+  auto listener = listen(host, port, options, &error);
   if (error) {
     throw Exception(error);
   }
   return listener;
 }
 
+std::shared_ptr<Listener> listen(const std::string& host, uint16_t port) {
+  return listen(host, port, ListenOptions());
+}
+
 }  // namespace impl
 }  // namespace tcp
 }  // namespace coro
@@ -0,0 +1,73 @@
+#include "coro/tcp/socket_options.hpp"
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include <cerrno>
+
+namespace coro {
+namespace tcp {
+namespace impl {
+
+/**
+ * @brief 设置一个整数类型的选项。
+ */
+static std::error_code setInt(int fd, int level, int name, int value) {
+  if (setsockopt(fd, level, name, &value, sizeof(value)) != 0) {
+    return std::error_code(errno, std::system_category());
+  }
+  return std::error_code();
+}
+
+std::error_code applySocketOptions(int fd, const SocketOptions& options,
+                                   SocketRole role) {
+  // 被接受的套接字从监听套接字复制而来，除 TCP_QUICKACK 外的选项都已继承，
+  // 无需在每次 accept 后重复设置。
+  bool inherit = role == SocketRole::kAccepted;
+  bool listener = role == SocketRole::kListener;
+  // 依次设置每个非默认的选项，遇到错误时立即返回。
+  struct Option {
+    bool enabled;
+    int level;
+    int name;
+    int value;
+  };
+  const Option list[] = {
+      {options.no_delay && !inherit, IPPROTO_TCP, TCP_NODELAY, 1},
+      {options.quick_ack && !listener, IPPROTO_TCP, TCP_QUICKACK, 1},
+      {options.fast_open && listener, IPPROTO_TCP, TCP_FASTOPEN,
+       kFastOpenQueueLength},
+      {options.fast_open && role == SocketRole::kConnect, IPPROTO_TCP,
+       TCP_FASTOPEN_CONNECT, 1},
+      {options.send_buffer > 0 && !inherit, SOL_SOCKET, SO_SNDBUF,
+       options.send_buffer},
+      {options.receive_buffer > 0 && !inherit, SOL_SOCKET, SO_RCVBUF,
+       options.receive_buffer},
+      {options.busy_poll > 0 && !inherit, SOL_SOCKET, SO_BUSY_POLL,
+       options.busy_poll},
+      {options.not_sent_lowat > 0 && !inherit, IPPROTO_TCP, TCP_NOTSENT_LOWAT,
+       options.not_sent_lowat},
+      {options.keepalive_idle > 0 && !inherit, SOL_SOCKET, SO_KEEPALIVE, 1},
+      {options.keepalive_idle > 0 && !inherit, IPPROTO_TCP, TCP_KEEPIDLE,
+       options.keepalive_idle},
+      {options.keepalive_interval > 0 && !inherit, IPPROTO_TCP, TCP_KEEPINTVL,
+       options.keepalive_interval},
+      {options.keepalive_count > 0 && !inherit, IPPROTO_TCP, TCP_KEEPCNT,
+       options.keepalive_count},
+  };
+  for (const Option& option : list) {
+    if (!option.enabled) {
+      continue;
+    }
+    std::error_code error = setInt(fd, option.level, option.name, option.value);
+    if (error) {
+      return error;
+    }
+  }
+  return std::error_code();
+}
+
+}  // namespace impl
+}  // namespace tcp
+}  // namespace coro
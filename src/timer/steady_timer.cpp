@@ -1,5 +1,7 @@
 #include "coro/timer/steady_timer.hpp"
 
+#include "coro/sched/sched.hpp"
+
 namespace coro {
 namespace timer {
 
@@ -19,6 +21,7 @@ Promise<void> SteadyTimer::expiresAt(
       promise.resolve();
     }
   });
+  sched::setWaitTag("timer");
   return promise;
 }
 
@@ -33,6 +36,7 @@ Promise<void> SteadyTimer::expiresAfter(
       promise.resolve();
     }
   });
+  sched::setWaitTag("timer");
   return promise;
 }
 
@@ -1,5 +1,7 @@
 #include "coro/timer/system_timer.hpp"
 
+#include "coro/sched/sched.hpp"
+
 namespace coro {
 namespace timer {
 
@@ -19,6 +21,7 @@ Promise<void> SystemTimer::expiresAt(
       promise.resolve();
     }
   });
+  sched::setWaitTag("timer");
   return promise;
 }
 
@@ -33,6 +36,7 @@ Promise<void> SystemTimer::expiresAfter(
       promise.resolve();
     }
   });
+  sched::setWaitTag("timer");
   return promise;
 }
 
@@ -0,0 +1,37 @@
+#include "alloc_hook.hpp"
+
+#include <cstdlib>
+#include <new>
+
+// 计数器是平凡类型的 thread_local 变量，不需要动态初始化，
+// 可以在线程启动和退出的任何阶段安全访问。
+static thread_local size_t thread_allocs = 0;
+static thread_local size_t thread_frees = 0;
+
+// operator new[]、nothrow 版本和带大小的 operator delete 的默认实现
+// 都会调用以下两个函数，所以无需替换。
+void* operator new(size_t size) {
+  thread_allocs++;
+  void* ptr = malloc(size == 0 ? 1 : size);
+  if (!ptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+  if (ptr) {
+    thread_frees++;
+    free(ptr);
+  }
+}
+
+namespace coro {
+namespace test {
+
+size_t threadAllocs() { return thread_allocs; }
+
+size_t threadFrees() { return thread_frees; }
+
+}  // namespace test
+}  // namespace coro
@@ -0,0 +1,26 @@
+#ifndef CORO_TEST_ALLOC_HOOK_HPP_
+#define CORO_TEST_ALLOC_HOOK_HPP_
+
+#include <cstddef>
+
+namespace coro {
+namespace test {
+
+/**
+ * @brief 获取当前线程调用 operator new 的次数。
+ * alloc_hook.cpp 替换了全局的 operator new 和 operator delete，
+ * 链接了它的测试程序都会统计每个线程的内存分配。
+ * @return size_t 分配次数。
+ */
+size_t threadAllocs();
+
+/**
+ * @brief 获取当前线程调用 operator delete 释放非空指针的次数。
+ * @return size_t 释放次数。
+ */
+size_t threadFrees();
+
+}  // namespace test
+}  // namespace coro
+
+#endif  // CORO_TEST_ALLOC_HOOK_HPP_
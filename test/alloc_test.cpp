@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+
+#include "alloc_hook.hpp"
+#include "coro/http.hpp"
+#include "coro/redis.hpp"
+#include "coro/spawn.hpp"
+#include "coro/tcp.hpp"
+
+namespace coro {
+namespace test {
+
+// 热身的请求数，用于填满 Asio 的处理函数内存缓存等一次性分配。
+static constexpr size_t kWarmup = 100;
+// 统计分配次数的请求数。
+static constexpr size_t kIterations = 1000;
+
+// 当前实现中每个请求的分配次数实测值，包括客户端和服务端（在同一线程中）。
+// 优化减少了分配之后应当同步降低。
+static constexpr double kEchoBaseline = 28.1;
+static constexpr double kHttpBaseline = 95.1;
+static constexpr double kRedisBaseline = 121.1;
+// 允许超出实测值的比例。分配次数会随依赖库的版本和标准库的实现小幅变化，
+// 留出余量只拦截热路径上明显新增的分配。
+static constexpr double kBudgetSlack = 1.1;
+
+/**
+ * @brief 记录每个请求的分配次数，并检查其不超过实测值加上余量。
+ * @param name 测试的名称。
+ * @param allocs 平均每个请求的分配次数。
+ * @param baseline 实测值。
+ */
+static void checkBudget(const char* name, double allocs, double baseline) {
+  testing::Test::RecordProperty("allocs_per_request", std::to_string(allocs));
+  EXPECT_LE(allocs, baseline * kBudgetSlack)
+      << name << " baseline is " << baseline << " allocs/request";
+}
+
+/**
+ * @brief 在热身后重复执行请求，统计当前线程中平均每个请求的分配次数。
+ * @tparam Func 请求函数类型。
+ * @param request 执行一个完整请求的函数。
+ * @return double 平均每个请求的分配次数。
+ */
+template <typename Func>
+static double allocsPerRequest(const Func& request) {
+  for (size_t i = 0; i < kWarmup; i++) {
+    request();
+  }
+  size_t begin = threadAllocs();
+  for (size_t i = 0; i < kIterations; i++) {
+    request();
+  }
+  return static_cast<double>(threadAllocs() - begin) / kIterations;
+}
+
+TEST(AllocTest, Echo) {
+  auto listener = tcp::listen(0);
+  auto server = spawn([listener]() {
+    auto conn = listener->accept().await();
+    char buf[256];
+    for (;;) {
+      size_t n = conn->readline(buf, sizeof(buf)).await();
+      if (n == 0) {
+        break;
+      }
+      conn->write(buf, n).await();
+    }
+  });
+
+  auto conn = tcp::connect("127.0.0.1", listener->port()).await();
+  const char line[] = "hello, world\n";
+  char buf[256];
+  double allocs = allocsPerRequest([&conn, &line, &buf]() {
+    conn->write(line, strlen(line)).await();
+    size_t n = conn->readline(buf, sizeof(buf)).await();
+    ASSERT_EQ(n, strlen(line));
+  });
+  conn->close();
+  std::error_code error;
+  server.await(&error);
+
+  checkBudget("echo", allocs, kEchoBaseline);
+}
+
+TEST(AllocTest, Http) {
+  auto listener = tcp::listen(0);
+  auto server = spawn([listener]() {
+    Stream conn = listener->accept().await();
+    http::protocol::Response resp;
+    resp.version = "HTTP/1.1";
+    resp.code = 200;
+    resp.reason = "OK";
+    resp.headers = {{"Content-Length", "0"}};
+    for (;;) {
+      auto req = http::protocol::readReq(conn).await();
+      http::protocol::writeResp(conn, resp).await();
+    }
+  });
+
+  Stream conn = tcp::connect("127.0.0.1", listener->port()).await();
+  http::protocol::Request req;
+  req.method = "GET";
+  req.url = "/index.html";
+  req.version = "HTTP/1.1";
+  req.headers = {{"Host", "localhost"}, {"Accept", "*/*"}};
+  double allocs = allocsPerRequest([&conn, &req]() {
+    http::protocol::writeReq(conn, req).await();
+    auto resp = http::protocol::readResp(conn).await();
+    ASSERT_EQ(resp.code, 200);
+  });
+  conn->close();
+  std::error_code error;
+  server.await(&error);
+
+  checkBudget("http", allocs, kHttpBaseline);
+}
+
+TEST(AllocTest, Redis) {
+  // 对每条命令都回复 +OK 的 Redis 服务器。
+  auto listener = tcp::listen(0);
+  auto server = spawn([listener]() {
+    Stream conn = listener->accept().await();
+    auto ok = redis::protocol::SimpleStringField::from("OK");
+    for (;;) {
+      redis::protocol::readField(conn).await();
+      redis::protocol::writeField(conn, ok).await();
+    }
+  });
+
+  redis::client::Client client;
+  client.connect("127.0.0.1", listener->port()).await();
+  double allocs = allocsPerRequest([&client]() {
+    auto resp = client.exec({"SET", "key", "value"}).await();
+    ASSERT_EQ(resp->type(), redis::protocol::FieldType::kSimpleString);
+  });
+  client.close();
+  std::error_code error;
+  server.await(&error);
+
+  checkBudget("redis", allocs, kRedisBaseline);
+}
+
+}  // namespace test
+}  // namespace coro
@@ -0,0 +1,54 @@
+#include "coro/buffer_pool.hpp"
+
+#include <gtest/gtest.h>
+
+namespace coro {
+
+TEST(BufferPoolTest, SizeClasses) {
+  EXPECT_EQ(BufferPool::capacityFor(1), kMinPooledBufferSize);
+  EXPECT_EQ(BufferPool::capacityFor(256), 256);
+  EXPECT_EQ(BufferPool::capacityFor(257), 512);
+  EXPECT_EQ(BufferPool::capacityFor(16 * 1024), 16 * 1024);
+  EXPECT_EQ(BufferPool::capacityFor(kMaxPooledBufferSize),
+            kMaxPooledBufferSize);
+  // 超过最大尺寸类时不取整。
+  EXPECT_EQ(BufferPool::capacityFor(kMaxPooledBufferSize + 1),
+            kMaxPooledBufferSize + 1);
+}
+
+TEST(BufferPoolTest, Reuse) {
+  BufferPool pool;
+  auto buf = pool.acquire(300);
+  char* ptr = buf.get();
+  pool.release(std::move(buf), 300);
+  EXPECT_EQ(pool.stats().cached_buffers, 1);
+  EXPECT_EQ(pool.stats().cached_bytes, 512);
+
+  // 同一尺寸类的请求复用该缓冲区，其他尺寸类的请求新分配。
+  auto other = pool.acquire(1024);
+  EXPECT_EQ(pool.acquire(400).get(), ptr);
+  EXPECT_EQ(pool.stats().hits, 1);
+  EXPECT_EQ(pool.stats().misses, 2);
+  EXPECT_EQ(pool.stats().cached_bytes, 0);
+  EXPECT_DOUBLE_EQ(pool.stats().hitRate(), 1.0 / 3);
+
+  auto large = pool.acquire(kMaxPooledBufferSize + 1);
+  pool.release(std::move(large), kMaxPooledBufferSize + 1);
+  EXPECT_EQ(pool.stats().oversized, 1);
+  EXPECT_EQ(pool.stats().cached_buffers, 0);
+}
+
+TEST(BufferPoolTest, MaxCachedBytes) {
+  BufferPool pool(1024);
+  auto a = pool.acquire(512);
+  auto b = pool.acquire(512);
+  auto c = pool.acquire(512);
+  pool.release(std::move(a), 512);
+  pool.release(std::move(b), 512);
+  // 空闲缓冲区的总大小已达上限，直接释放。
+  pool.release(std::move(c), 512);
+  EXPECT_EQ(pool.stats().cached_bytes, 1024);
+  EXPECT_EQ(pool.stats().drops, 1);
+}
+
+}  // namespace coro
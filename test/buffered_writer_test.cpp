@@ -0,0 +1,144 @@
+#include "coro/buffered_writer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "coro/pipe.hpp"
+#include "coro/sched.hpp"
+#include "coro/sleep.hpp"
+#include "coro/spawn.hpp"
+
+namespace coro {
+
+/**
+ * @brief 记录每次写入的流。hold 为 true 时写入不会自动完成，
+ * 需要调用 complete()。
+ */
+class RecordingStream : public impl::Stream {
+ public:
+  Promise<size_t> write(const char* buf, size_t len) override {
+    writes.emplace_back(buf, len);
+    Promise<size_t> promise;
+    if (hold) {
+      held.push_back(promise);
+    } else {
+      promise.resolve(len);
+    }
+    return promise;
+  }
+
+  void close() override {}
+
+  // 完成第一个未完成的写入。
+  void complete() {
+    auto promise = held.front();
+    held.erase(held.begin());
+    promise.resolve(writes[writes.size() - held.size() - 1].size());
+  }
+
+  std::vector<std::string> writes;
+  std::vector<Promise<size_t>> held;
+  bool hold = false;
+
+ protected:
+  Promise<size_t> readSome(char* buf, size_t len) override {
+    Promise<size_t> promise;
+    promise.resolve(0);
+    return promise;
+  }
+};
+
+TEST(BufferedWriterTest, FlushOnIdle) {
+  auto stream = std::make_shared<RecordingStream>();
+  auto writer = bufferWrites(stream);
+  // 多个协程在同一轮调度中的写入被合并为一次写入。
+  auto first = spawn([writer]() { writer->write("a", 1).await(); });
+  auto second = spawn([writer]() { writer->write("b", 1).await(); });
+  writer->write("c", 1).await();
+  EXPECT_TRUE(stream->writes.empty());
+  EXPECT_EQ(writer->buffered(), 1);
+
+  // 主协程阻塞后调度器空闲，缓冲区被写入底层流。
+  first.await();
+  second.await();
+  milliSleep(1).await();
+  ASSERT_EQ(stream->writes.size(), 1);
+  EXPECT_EQ(stream->writes[0], "cab");
+  EXPECT_EQ(writer->buffered(), 0);
+}
+
+TEST(BufferedWriterTest, FlushOnThreshold) {
+  auto stream = std::make_shared<RecordingStream>();
+  auto writer = bufferWrites(stream, 4);
+  writer->write("ab", 2).await();
+  EXPECT_TRUE(stream->writes.empty());
+  writer->write("cd", 2).await();
+  ASSERT_EQ(stream->writes.size(), 1);
+  EXPECT_EQ(stream->writes[0], "abcd");
+}
+
+TEST(BufferedWriterTest, ExplicitFlush) {
+  auto stream = std::make_shared<RecordingStream>();
+  stream->hold = true;
+  auto writer = bufferWrites(stream);
+  writer->write("ab", 2).await();
+  auto flushed = writer->flush();
+  ASSERT_EQ(stream->writes.size(), 1);
+  // 写入期间到达的数据在本次写入完成后一起写入。
+  writer->write("c", 1).await();
+  writer->write("d", 1).await();
+  stream->complete();
+  ASSERT_EQ(stream->writes.size(), 2);
+  EXPECT_EQ(stream->writes[1], "cd");
+
+  // flush 只等待调用之前写入的数据。
+  flushed.await();
+  EXPECT_EQ(writer->buffered(), 2);
+  stream->complete();
+  EXPECT_EQ(writer->buffered(), 0);
+}
+
+TEST(BufferedWriterTest, BackPressure) {
+  auto stream = std::make_shared<RecordingStream>();
+  stream->hold = true;
+  auto writer = bufferWrites(stream, 4, 4);
+  writer->write("abcd", 4).await();
+  ASSERT_EQ(stream->writes.size(), 1);
+  writer->write("efgh", 4).await();
+
+  // 缓冲区已满，写入方阻塞直至底层流的写入完成。
+  bool done = false;
+  auto blocked = spawn([writer, &done]() {
+    writer->write("ij", 2).await();
+    done = true;
+  });
+  yield();
+  EXPECT_FALSE(done);
+  stream->complete();
+  blocked.await();
+  EXPECT_TRUE(done);
+  ASSERT_EQ(stream->writes.size(), 2);
+  EXPECT_EQ(stream->writes[1], "efgh");
+  stream->complete();
+  ASSERT_EQ(stream->writes.size(), 3);
+  EXPECT_EQ(stream->writes[2], "ij");
+  stream->complete();
+}
+
+TEST(BufferedWriterTest, Error) {
+  auto ends = pipe();
+  auto writer = bufferWrites(ends.first);
+  ends.second->close();
+  writer->write("ab", 2).await();
+
+  // 写入底层流的错误通过 flush 和之后的写入返回。
+  std::error_code error;
+  writer->flush().await(&error);
+  EXPECT_EQ(error, std::make_error_code(std::errc::broken_pipe));
+  writer->write("c", 1).await(&error);
+  EXPECT_EQ(error, std::make_error_code(std::errc::broken_pipe));
+}
+
+}  // namespace coro
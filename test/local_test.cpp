@@ -0,0 +1,69 @@
+#include "coro/local.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "coro/sched.hpp"
+#include "coro/spawn.hpp"
+
+namespace coro {
+
+static CoroLocal<int> local_int;
+static CoroLocal<std::string> local_str;
+
+TEST(CoroLocalTest, DefaultConstruct) {
+  auto promise = spawn([]() {
+    EXPECT_FALSE(local_int.has());
+    EXPECT_EQ(local_int.get(), 0);
+    EXPECT_TRUE(local_int.has());
+  });
+  promise.await();
+}
+
+TEST(CoroLocalTest, Isolated) {
+  local_str.set("main");
+  auto p1 = spawn([]() {
+    local_str.set("p1");
+    yield();
+    EXPECT_EQ(*local_str, "p1");
+  });
+  auto p2 = spawn([]() {
+    local_str.set("p2");
+    yield();
+    EXPECT_EQ(*local_str, "p2");
+  });
+  p1.await();
+  p2.await();
+  EXPECT_EQ(*local_str, "main");
+  local_str.reset();
+  EXPECT_FALSE(local_str.has());
+}
+
+class SetOnDestory {
+ public:
+  SetOnDestory() = default;
+  ~SetOnDestory() {
+    if (val_) {
+      *val_ = 1;
+    }
+  }
+
+  int* val_ = nullptr;
+};
+
+static CoroLocal<SetOnDestory> local_obj;
+
+TEST(CoroLocalTest, DestroyOnExit) {
+  int val = 0;
+  auto promise = spawn([&val]() {
+    local_obj->val_ = &val;
+    yield();
+  });
+  yield();
+  EXPECT_EQ(val, 0);
+  promise.await();
+  EXPECT_EQ(val, 1);
+}
+
+}  // namespace coro
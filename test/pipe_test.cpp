@@ -0,0 +1,200 @@
+#include "coro/pipe.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "coro/http.hpp"
+#include "coro/redis.hpp"
+#include "coro/sched.hpp"
+#include "coro/spawn.hpp"
+
+namespace coro {
+
+TEST(PipeTest, ReadWrite) {
+  auto ends = pipe();
+  ends.first->write("hello", 5).await();
+  char buf[16];
+  ASSERT_EQ(ends.second->read(buf, sizeof(buf)).await(), 5);
+  EXPECT_EQ(std::string(buf, 5), "hello");
+
+  // 两个方向互不影响。
+  ends.second->write("world", 5).await();
+  ASSERT_EQ(ends.first->read(buf, sizeof(buf)).await(), 5);
+  EXPECT_EQ(std::string(buf, 5), "world");
+}
+
+TEST(PipeTest, ReadBlocks) {
+  auto ends = pipe();
+  std::string received;
+  auto reader = spawn([&ends, &received]() {
+    char buf[16];
+    size_t n = ends.second->read(buf, sizeof(buf)).await();
+    received.assign(buf, n);
+  });
+  // 读取方阻塞在空管道上。
+  yield();
+  EXPECT_TRUE(received.empty());
+  ends.first->write("ping", 4).await();
+  reader.await();
+  EXPECT_EQ(received, "ping");
+}
+
+TEST(PipeTest, WriteBlocks) {
+  // 容量小于写入的数据，写入方阻塞直至读取方取走数据。
+  auto ends = pipe(4);
+  std::string data = "0123456789abcdef";
+  auto writer = spawn([&ends, &data]() {
+    return ends.first->write(data.data(), data.size()).await();
+  });
+
+  std::string received;
+  char buf[3];
+  while (received.size() < data.size()) {
+    size_t n = ends.second->read(buf, sizeof(buf)).await();
+    received.append(buf, n);
+  }
+  EXPECT_EQ(writer.await(), data.size());
+  EXPECT_EQ(received, data);
+}
+
+TEST(PipeTest, ConcurrentWriters) {
+  // 多个写入方同时阻塞时按调用的顺序排队，每个都会完成。
+  auto ends = pipe(4);
+  std::string first = "aaaaaaaa";
+  std::string second = "bbbbbbbb";
+  auto writer1 = spawn([&ends, &first]() {
+    return ends.first->write(first.data(), first.size()).await();
+  });
+  auto writer2 = spawn([&ends, &second]() {
+    return ends.first->write(second.data(), second.size()).await();
+  });
+
+  std::string received;
+  char buf[3];
+  while (received.size() < first.size() + second.size()) {
+    size_t n = ends.second->read(buf, sizeof(buf)).await();
+    received.append(buf, n);
+  }
+  EXPECT_EQ(writer1.await(), first.size());
+  EXPECT_EQ(writer2.await(), second.size());
+  EXPECT_EQ(received, first + second);
+}
+
+TEST(PipeTest, ConcurrentReaders) {
+  // 多个读取方同时阻塞时按调用的顺序得到数据。
+  auto ends = pipe();
+  std::vector<Promise<std::string>> readers;
+  for (int i = 0; i < 2; i++) {
+    readers.push_back(spawn([&ends]() {
+      char buf[4];
+      size_t n = ends.second->read(buf, sizeof(buf)).await();
+      return std::string(buf, n);
+    }));
+  }
+  yield();
+  ends.first->write("abcdefgh", 8).await();
+  EXPECT_EQ(readers[0].await(), "abcd");
+  EXPECT_EQ(readers[1].await(), "efgh");
+
+  // 关闭写端时所有阻塞的读取方都读取到 EOF。
+  readers.clear();
+  for (int i = 0; i < 2; i++) {
+    readers.push_back(spawn([&ends]() {
+      char buf[4];
+      size_t n = ends.second->read(buf, sizeof(buf)).await();
+      return std::string(buf, n);
+    }));
+  }
+  yield();
+  ends.first->shutdownWrite();
+  EXPECT_EQ(readers[0].await(), "");
+  EXPECT_EQ(readers[1].await(), "");
+}
+
+TEST(PipeTest, Close) {
+  auto ends = pipe();
+  ends.first->write("bye", 3).await();
+  ends.first->close();
+
+  // 对端先读完剩余的数据，再读取到 EOF。
+  char buf[16];
+  EXPECT_EQ(ends.second->read(buf, sizeof(buf)).await(), 3);
+  EXPECT_EQ(ends.second->read(buf, sizeof(buf)).await(), 0);
+
+  std::error_code error;
+  ends.second->write("x", 1).await(&error);
+  EXPECT_EQ(error, std::make_error_code(std::errc::broken_pipe));
+}
+
+TEST(PipeTest, CloseWakesReader) {
+  auto ends = pipe();
+  auto reader = spawn([&ends]() {
+    char buf[16];
+    return ends.second->read(buf, sizeof(buf)).await();
+  });
+  yield();
+  ends.first.reset();
+  EXPECT_EQ(reader.await(), 0);
+}
+
+TEST(PipeTest, Http) {
+  auto ends = pipe();
+  Stream client = ends.first;
+  Stream server = ends.second;
+  auto handler = spawn([server]() {
+    auto req = http::protocol::readReq(server).await();
+    http::protocol::Response resp;
+    resp.version = req.version;
+    resp.code = 200;
+    resp.reason = "OK";
+    resp.headers = {{"Content-Length", "0"}};
+    http::protocol::writeResp(server, resp).await();
+    return req.url;
+  });
+
+  http::protocol::Request req;
+  req.method = "GET";
+  req.url = "/index.html";
+  req.version = "HTTP/1.1";
+  req.headers = {{"Host", "localhost"}};
+  http::protocol::writeReq(client, req).await();
+  auto resp = http::protocol::readResp(client).await();
+  EXPECT_EQ(resp.code, 200);
+  EXPECT_EQ(handler.await(), "/index.html");
+}
+
+TEST(PipeTest, Redis) {
+  auto ends = pipe();
+  Stream client = ends.first;
+  Stream server = ends.second;
+  auto handler = spawn([server]() {
+    auto field = redis::protocol::readField(server).await();
+    redis::protocol::writeField(server,
+                                redis::protocol::IntegerField::from(42))
+        .await();
+    return field->type();
+  });
+
+  auto array = redis::protocol::ArrayField::null();
+  array->mut_fields().push_back(redis::protocol::BulkStringField::from("GET"));
+  redis::protocol::writeField(client, array).await();
+  auto resp = redis::protocol::readField(client).await();
+  ASSERT_EQ(resp->type(), redis::protocol::FieldType::kInteger);
+  auto integer = std::static_pointer_cast<redis::protocol::IntegerField>(resp);
+  EXPECT_EQ(integer->value(), 42);
+  EXPECT_EQ(handler.await(), redis::protocol::FieldType::kArray);
+}
+
+TEST(PipeTest, HttpEof) {
+  auto ends = pipe();
+  Stream server = ends.second;
+  ends.first->close();
+  std::error_code error;
+  http::protocol::readReq(server).await(&error);
+  EXPECT_EQ(error, std::error_code(http::protocol::Errc::kEof,
+                                   http::protocol::errorCategory()));
+}
+
+}  // namespace coro
@@ -0,0 +1,121 @@
+#include "coro/pump.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "coro/pipe.hpp"
+#include "coro/spawn.hpp"
+#include "coro/tcp.hpp"
+
+namespace coro {
+
+/**
+ * @brief 读取直至 EOF。
+ */
+static std::string readAll(Stream stream) {
+  std::string data;
+  char buf[4096];
+  for (;;) {
+    std::error_code error;
+    size_t n = stream->read(buf, sizeof(buf)).await(&error);
+    if (n == 0 || error) {
+      return data;
+    }
+    data.append(buf, n);
+  }
+}
+
+/**
+ * @brief client_a 发送请求并半关闭，client_b 读完请求后发送响应并半关闭。
+ */
+static void exchange(Stream client_a, Stream client_b,
+                     const std::string& request, const std::string& response) {
+  auto a = spawn([client_a, &request]() {
+    client_a->write(request.data(), request.size()).await();
+    client_a->shutdownWrite();
+    return readAll(client_a);
+  });
+  auto b = spawn([client_b, &response]() {
+    std::string received = readAll(client_b);
+    client_b->write(response.data(), response.size()).await();
+    client_b->shutdownWrite();
+    return received;
+  });
+  EXPECT_TRUE(b.await() == request);
+  EXPECT_TRUE(a.await() == response);
+}
+
+TEST(PumpTest, Pipe) {
+  auto left = pipe(4096);
+  auto right = pipe(4096);
+  // 缓冲区小于数据量，读写交替进行。
+  auto result = pump(left.second, right.first, 1024);
+
+  std::string request(100 * 1000, 'q');
+  std::string response(10 * 1000, 'r');
+  exchange(left.first, right.second, request, response);
+  PumpResult counts = result.await();
+  EXPECT_EQ(counts.a_to_b, request.size());
+  EXPECT_EQ(counts.b_to_a, response.size());
+}
+
+TEST(PumpTest, Splice) {
+  auto listener = tcp::listen(0);
+  auto accept = spawn([listener]() { return listener->accept().await(); });
+  auto client_a = tcp::connect("127.0.0.1", listener->port()).await();
+  auto server_a = accept.await();
+  accept = spawn([listener]() { return listener->accept().await(); });
+  auto client_b = tcp::connect("127.0.0.1", listener->port()).await();
+  auto server_b = accept.await();
+
+  auto result = pump(server_a, server_b);
+  std::string request(1024 * 1024, 'q');
+  std::string response(64 * 1024, 'r');
+  exchange(client_a, client_b, request, response);
+  PumpResult counts = result.await();
+  EXPECT_EQ(counts.a_to_b, request.size());
+  EXPECT_EQ(counts.b_to_a, response.size());
+}
+
+TEST(PumpTest, Error) {
+  auto left = pipe(1024);
+  auto right = pipe(1024);
+  auto result = pump(left.second, right.first, 256);
+
+  // 一端完全关闭后，转发到该端的写入失败，两个流都被关闭。
+  right.second->close();
+  std::string data(4096, 'x');
+  std::error_code error;
+  left.first->write(data.data(), data.size()).await(&error);
+  result.await(&error);
+  EXPECT_EQ(error, std::errc::broken_pipe);
+}
+
+TEST(PumpTest, TcpError) {
+  auto listener = tcp::listen(0);
+  auto accept = spawn([listener]() { return listener->accept().await(); });
+  auto client = tcp::connect("127.0.0.1", listener->port()).await();
+  auto server_a = accept.await();
+  accept = spawn([listener]() { return listener->accept().await(); });
+  auto backend = tcp::connect("127.0.0.1", listener->port()).await();
+  auto server_b = accept.await();
+  auto result = pump(server_a, server_b);
+
+  // 后端关闭后客户端继续发送，splice 写入已重置的连接失败，
+  // pump 被拒绝而不是因 SIGPIPE 终止进程。
+  backend->close();
+  std::string data(64 * 1024, 'x');
+  auto writer = spawn([client, &data]() {
+    std::error_code error;
+    while (!error) {
+      client->write(data.data(), data.size()).await(&error);
+    }
+  });
+  std::error_code error;
+  result.await(&error);
+  EXPECT_TRUE(error);
+  writer.await();
+}
+
+}  // namespace coro
@@ -0,0 +1,75 @@
+#include "coro/scan.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace coro {
+namespace scan {
+
+// CPU 支持的全部指令集。
+static std::vector<Isa> supportedIsas() {
+  Isa saved = isa();
+  std::vector<Isa> isas;
+  for (Isa candidate : {Isa::kScalar, Isa::kSse2, Isa::kAvx2}) {
+    if (setIsa(candidate)) {
+      isas.push_back(candidate);
+    }
+  }
+  setIsa(saved);
+  return isas;
+}
+
+// 与逐字节扫描的结果比较，覆盖向量的边界和不足一个向量的尾部。
+TEST(ScanTest, MatchesScalar) {
+  Isa saved = isa();
+  std::string data(100, 'a');
+  const char kSet[] = {' ', ':', '\r', '\n'};
+  for (Isa candidate : supportedIsas()) {
+    SCOPED_TRACE(isaName(candidate));
+    setIsa(candidate);
+    for (size_t len = 0; len <= 70; len++) {
+      for (size_t pos = 0; pos <= len; pos++) {
+        const char* begin = data.data() + 1;
+        const char* end = begin + len;
+        std::string line(len, 'a');
+        if (pos < len) {
+          line[pos] = ':';
+        }
+        if (pos + 1 < len) {
+          line[pos] = '\r';
+          line[pos + 1] = '\n';
+        }
+        data.replace(1, len, line);
+
+        const char* expect = pos + 1 < len ? begin + pos : end;
+        EXPECT_EQ(findCrlf(begin, end), expect) << len << " " << pos;
+        expect = pos < len ? begin + pos : end;
+        EXPECT_EQ(findAnyOf(begin, end, kSet, sizeof(kSet)), expect);
+        char chr = pos + 1 < len ? '\r' : ':';
+        EXPECT_EQ(findByte(begin, end, chr), expect);
+        data.replace(1, len, std::string(len, 'a'));
+      }
+    }
+  }
+  setIsa(saved);
+}
+
+TEST(ScanTest, LoneCr) {
+  Isa saved = isa();
+  // \r 后面不是 \n，以及 \n 在 \r 之前，都不算 \r\n。
+  std::string data = std::string(40, 'a') + "\r" + std::string(20, 'b') +
+                     "\n\r" + std::string(40, 'c') + "\r\n";
+  for (Isa candidate : supportedIsas()) {
+    SCOPED_TRACE(isaName(candidate));
+    setIsa(candidate);
+    const char* end = data.data() + data.size();
+    EXPECT_EQ(findCrlf(data.data(), end), end - 2);
+    EXPECT_EQ(findCrlf(data.data(), end - 1), end - 1);
+  }
+  setIsa(saved);
+}
+
+}  // namespace scan
+}  // namespace coro
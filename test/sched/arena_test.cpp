@@ -0,0 +1,112 @@
+#include "coro/sched/arena.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "coro/arena.hpp"
+#include "coro/spawn.hpp"
+
+namespace coro {
+namespace sched {
+
+TEST(ArenaTest, Allocate) {
+  Arena arena(1024);
+  auto p1 = arena.allocate(10, 1);
+  auto p2 = arena.allocate(8, 8);
+  EXPECT_NE(p1, nullptr);
+  EXPECT_NE(p2, nullptr);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(p2) % 8, 0);
+  EXPECT_EQ(arena.live(), 2);
+  EXPECT_EQ(arena.capacity(), 1024);
+  arena.deallocate(p1);
+  arena.deallocate(p2);
+  EXPECT_EQ(arena.live(), 0);
+}
+
+TEST(ArenaTest, LargeAllocate) {
+  Arena arena(1024);
+  auto p = arena.allocate(4096, 16);
+  EXPECT_NE(p, nullptr);
+  EXPECT_GE(arena.capacity(), 4096);
+  arena.deallocate(p);
+}
+
+TEST(ArenaTest, RewindWhenEmpty) {
+  Arena arena(1024);
+  auto p1 = arena.allocate(100, 1);
+  arena.deallocate(p1);
+  auto p2 = arena.allocate(100, 1);
+  EXPECT_EQ(p1, p2);
+  arena.deallocate(p2);
+  EXPECT_EQ(arena.capacity(), 1024);
+}
+
+TEST(ArenaTest, ReuseBlocks) {
+  Arena arena(1024);
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 10; i++) {
+    ptrs.push_back(arena.allocate(512, 1));
+  }
+  size_t capacity = arena.capacity();
+  for (void* ptr : ptrs) {
+    arena.deallocate(ptr);
+  }
+  for (int i = 0; i < 10; i++) {
+    ptrs[i] = arena.allocate(512, 1);
+  }
+  EXPECT_EQ(arena.capacity(), capacity);
+  for (void* ptr : ptrs) {
+    arena.deallocate(ptr);
+  }
+}
+
+TEST(ArenaTest, PinnedAllocation) {
+  // 一个长期存活的分配使 Arena 无法回退，内存块数仍然有上限。
+  Arena arena(1024, 4);
+  void* pinned = arena.allocate(16, 8);
+  for (int i = 0; i < 10000; i++) {
+    void* p1 = arena.allocate(200, 8);
+    void* p2 = arena.allocate(300, 8);
+    arena.deallocate(p1);
+    arena.deallocate(p2);
+  }
+  EXPECT_LE(arena.capacity(), 4 * 1024);
+  EXPECT_EQ(arena.live(), 1);
+  arena.deallocate(pinned);
+  EXPECT_EQ(arena.live(), 0);
+
+  // 所有分配都被释放后回退到第一个内存块。
+  void* p = arena.allocate(16, 8);
+  EXPECT_EQ(p, pinned);
+  arena.deallocate(p);
+}
+
+TEST(ArenaTest, CoroArena) {
+  std::shared_ptr<Arena> arena;
+  std::shared_ptr<std::string> str;
+  auto promise = spawn([&arena, &str]() {
+    enableArena();
+    arena = currentPtr()->arena();
+    ASSERT_NE(arena, nullptr);
+    str = makeShared<std::string>("hello");
+    using String =
+        std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+    String tmp(100, 'a');
+    EXPECT_EQ(arena->live(), 2);
+  });
+  promise.await();
+  // 协程已退出，但 str 仍然持有 Arena 的引用。
+  EXPECT_EQ(arena->live(), 1);
+  EXPECT_EQ(*str, "hello");
+  std::weak_ptr<Arena> weak = arena;
+  arena.reset();
+  EXPECT_FALSE(weak.expired());
+  str.reset();
+  EXPECT_TRUE(weak.expired());
+}
+
+}  // namespace sched
+}  // namespace coro
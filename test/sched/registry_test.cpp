@@ -0,0 +1,116 @@
+#include "coro/sched/registry.hpp"
+
+#include <gtest/gtest.h>
+#include <signal.h>
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+
+#include "coro/promise.hpp"
+#include "coro/sched.hpp"
+#include "coro/sleep.hpp"
+#include "coro/spawn.hpp"
+
+namespace coro {
+namespace sched {
+
+static const CoroInfo* find(const std::vector<CoroInfo>& coros, uint64_t id) {
+  auto iter =
+      std::find_if(coros.begin(), coros.end(),
+                   [id](const CoroInfo& info) { return info.id == id; });
+  return iter == coros.end() ? nullptr : &*iter;
+}
+
+TEST(RegistryTest, Coros) {
+  uint64_t coro_id = 0;
+  auto promise = spawn([&coro_id]() {
+    coro_id = currentPtr()->id();
+    milliSleep(10).await();
+  });
+  // 新协程被调度但从未运行。
+  auto infos = coros();
+  ASSERT_EQ(infos.size(), 2);
+  EXPECT_EQ(infos[0].id, currentPtr()->id());
+  EXPECT_EQ(infos[0].state, CoroState::kRunning);
+  EXPECT_EQ(infos[1].state, CoroState::kReady);
+  EXPECT_LT(infos[1].since_resume.count(), 0);
+  EXPECT_NE(infos[1].spawn_site, nullptr);
+
+  yield();
+  infos = coros(true);
+  const CoroInfo* info = find(infos, coro_id);
+  ASSERT_NE(info, nullptr);
+  EXPECT_EQ(info->state, CoroState::kBlocked);
+  EXPECT_STREQ(info->blocked_on, "sleep");
+  EXPECT_GE(info->since_resume.count(), 0);
+  EXPECT_FALSE(info->backtrace.empty());
+
+  promise.await();
+  EXPECT_EQ(find(coros(), coro_id), nullptr);
+  EXPECT_EQ(coros().size(), 1);
+}
+
+TEST(RegistryTest, StaleWaitTag) {
+  coro::Promise<void> gate;
+  uint64_t coro_id = 0;
+  auto promise = spawn([&gate, &coro_id]() {
+    coro_id = currentPtr()->id();
+    // 操作同步完成，标记不能留给之后的阻塞。
+    setWaitTag("stale");
+    coro::Promise<void> done;
+    done.resolve();
+    done.await();
+    gate.await();
+    // 让出 CPU 后标记过期。
+    setWaitTag("stale");
+    yield();
+    gate.await();
+  });
+
+  yield();
+  const CoroInfo* info = find(coros(), coro_id);
+  ASSERT_NE(info, nullptr);
+  EXPECT_EQ(info->state, CoroState::kBlocked);
+  EXPECT_EQ(info->blocked_on, nullptr);
+
+  gate.resolve();
+  gate = coro::Promise<void>();
+  yield();
+  yield();
+  info = find(coros(), coro_id);
+  ASSERT_NE(info, nullptr);
+  EXPECT_EQ(info->state, CoroState::kBlocked);
+  EXPECT_EQ(info->blocked_on, nullptr);
+  gate.resolve();
+  promise.await();
+}
+
+TEST(RegistryTest, Dump) {
+  auto promise = spawn([]() { milliSleep(10).await(); });
+  yield();
+  std::ostringstream out;
+  dumpCoros(out);
+  std::string dump = out.str();
+  EXPECT_NE(dump.find("2 coroutines: 1 running, 1 blocked"), std::string::npos);
+  EXPECT_NE(dump.find("1 blocked on sleep"), std::string::npos);
+  EXPECT_NE(dump.find("[blocked on sleep]"), std::string::npos);
+  // 协程函数的类型名包含定义它的测试。
+  EXPECT_NE(dump.find("spawned by"), std::string::npos);
+  EXPECT_NE(dump.find("RegistryTest_Dump"), std::string::npos);
+  promise.await();
+}
+
+TEST(RegistryTest, Signal) {
+  dumpCorosOnSignal(SIGUSR1);
+  testing::internal::CaptureStderr();
+  raise(SIGUSR1);
+  // 信号由 idle 协程处理。
+  milliSleep(10).await();
+  std::string dump = testing::internal::GetCapturedStderr();
+  EXPECT_NE(dump.find("1 coroutines: 1 blocked"), std::string::npos);
+  EXPECT_NE(dump.find("[blocked on sleep]"), std::string::npos);
+}
+
+}  // namespace sched
+}  // namespace coro
@@ -0,0 +1,130 @@
+#include "coro/sched/stats.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#include "coro/sched.hpp"
+#include "coro/sleep.hpp"
+#include "coro/spawn.hpp"
+
+namespace coro {
+namespace sched {
+
+/**
+ * @brief 占用 CPU 一段时间，期间不让出。
+ */
+static void spin(std::chrono::milliseconds duration) {
+  auto deadline = std::chrono::steady_clock::now() + duration;
+  while (std::chrono::steady_clock::now() < deadline) {
+  }
+}
+
+TEST(StatsTest, LatencyBucket) {
+  EXPECT_EQ(latencyBucket(0), 0);
+  EXPECT_EQ(latencyBucket(1), 0);
+  EXPECT_EQ(latencyBucket(2), 1);
+  EXPECT_EQ(latencyBucket(1023), 9);
+  EXPECT_EQ(latencyBucket(1024), 10);
+  EXPECT_EQ(latencyBucket(UINT64_MAX), kLatencyBuckets - 1);
+}
+
+TEST(StatsTest, WakeUpLatency) {
+  Stats stats;
+  EXPECT_EQ(stats.wakeUpLatency(0.5).count(), 0);
+  stats.wakeup_latency[3] = 90;
+  stats.wakeup_latency[10] = 10;
+  EXPECT_EQ(stats.wakeUpLatency(0.5).count(), 16);
+  EXPECT_EQ(stats.wakeUpLatency(0.99).count(), 2048);
+  EXPECT_EQ(stats.wakeUpLatency(1).count(), 2048);
+}
+
+TEST(StatsTest, Counters) {
+  Stats before = stats();
+  auto promise = spawn([]() {
+    yield();
+    milliSleep(1).await();
+  });
+  Stats running = stats();
+  EXPECT_EQ(running.spawns, before.spawns + 1);
+  EXPECT_EQ(running.ready, before.ready + 1);
+  promise.await();
+  Stats after = stats();
+  EXPECT_EQ(after.exits, before.exits + 1);
+  EXPECT_EQ(after.ready, 0);
+  EXPECT_EQ(after.blocked, 0);
+  EXPECT_GT(after.switches, before.switches);
+  EXPECT_GT(after.idle_time, before.idle_time);
+
+  uint64_t wakeups = 0;
+  for (size_t i = 0; i < kLatencyBuckets; i++) {
+    wakeups += after.wakeup_latency[i] - before.wakeup_latency[i];
+  }
+  // 主协程等待 promise，新协程等待定时器，各被唤醒一次。
+  EXPECT_EQ(wakeups, 2);
+}
+
+TEST(StatsTest, Global) {
+  spawn([]() {}).await();
+  uint64_t main_spawns = stats().spawns;
+  Stats thread_stats, global;
+  std::thread thread([&thread_stats, &global]() {
+    spawn([]() {}).await();
+    thread_stats = stats();
+    global = globalStats();
+  });
+  thread.join();
+  EXPECT_EQ(thread_stats.spawns, 1);
+  EXPECT_EQ(global.spawns, main_spawns + thread_stats.spawns);
+}
+
+TEST(StatsTest, QueueDelay) {
+  using std::chrono::milliseconds;
+  // 在单独的线程中测试，不影响其他测试中调度器的状态。
+  std::thread thread([]() {
+    EXPECT_EQ(queueDelay().count(), 0);
+    monitorQueueDelay(milliseconds(20));
+    milliSleep(50).await();
+    // 一次长时间的阻塞只推迟一次探测，不被视为排队。
+    spin(milliseconds(50));
+    milliSleep(50).await();
+    EXPECT_LT(queueDelay(), milliseconds(5));
+
+    // 持续占用 CPU，每次探测都被推迟。
+    bool loaded = true;
+    auto load = spawn([&loaded]() {
+      while (loaded) {
+        spin(milliseconds(10));
+        milliSleep(0).await();
+      }
+    });
+    milliSleep(100).await();
+    EXPECT_GE(queueDelay(), milliseconds(2));
+    loaded = false;
+    load.await();
+    milliSleep(60).await();
+    EXPECT_LT(queueDelay(), milliseconds(2));
+
+    // 每次 monitorQueueDelay 都被撤销后停止测量，负载不再被探测到。
+    monitorQueueDelay(milliseconds(20));
+    stopQueueDelay();
+    stopQueueDelay();
+    EXPECT_EQ(queueDelay().count(), 0);
+    loaded = true;
+    load = spawn([&loaded]() {
+      while (loaded) {
+        spin(milliseconds(10));
+        milliSleep(0).await();
+      }
+    });
+    milliSleep(60).await();
+    EXPECT_EQ(queueDelay().count(), 0);
+    loaded = false;
+    load.await();
+  });
+  thread.join();
+}
+
+}  // namespace sched
+}  // namespace coro
@@ -0,0 +1,77 @@
+#include "coro/sched/trace.hpp"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+
+#include "coro/sched.hpp"
+#include "coro/sleep.hpp"
+#include "coro/spawn.hpp"
+
+namespace coro {
+namespace sched {
+
+TEST(TraceBufferTest, Record) {
+  TraceBuffer buffer(4, 1);
+  buffer.record(TraceEvent::kSpawn, 1, nullptr);
+  buffer.record(TraceEvent::kResume, 1, nullptr);
+  auto records = buffer.snapshot();
+  ASSERT_EQ(records.size(), 2);
+  EXPECT_EQ(records[0].event, TraceEvent::kSpawn);
+  EXPECT_EQ(records[1].event, TraceEvent::kResume);
+  EXPECT_LE(records[0].time, records[1].time);
+}
+
+TEST(TraceBufferTest, Overwrite) {
+  TraceBuffer buffer(3, 1);
+  for (uint64_t i = 0; i < 10; i++) {
+    buffer.record(TraceEvent::kUser, i, nullptr);
+  }
+  // 容量被向上取整为 4，只保留最新的 4 条记录。其中最旧的一条所在的槽位
+  // 是下一条记录的写入位置，可能正在被覆盖，快照不返回它。
+  auto records = buffer.snapshot();
+  ASSERT_EQ(records.size(), 3);
+  EXPECT_EQ(records[0].coro_id, 7);
+  EXPECT_EQ(records[2].coro_id, 9);
+}
+
+TEST(TraceBufferTest, NotFull) {
+  // 缓冲区未满时下一条记录的写入位置是空的，所有记录都完整。
+  TraceBuffer buffer(4, 1);
+  for (uint64_t i = 0; i < 3; i++) {
+    buffer.record(TraceEvent::kUser, i, nullptr);
+  }
+  auto records = buffer.snapshot();
+  ASSERT_EQ(records.size(), 3);
+  EXPECT_EQ(records[0].coro_id, 0);
+  EXPECT_EQ(records[2].coro_id, 2);
+}
+
+TEST(TraceTest, Dump) {
+  enableTrace();
+  uint64_t coro_id = 0;
+  auto promise = spawn([&coro_id]() {
+    coro_id = currentPtr()->id();
+    coro::trace("my \"tag\"");
+    milliSleep(1).await();
+  });
+  promise.await();
+  disableTrace();
+
+  std::ostringstream out;
+  dumpTrace(out);
+  std::string json = out.str();
+  std::string name = "\"coro " + std::to_string(coro_id) + "\"";
+  EXPECT_NE(json.find("\"traceEvents\""), std::string::npos);
+  EXPECT_NE(json.find(name), std::string::npos);
+  EXPECT_NE(json.find("\"name\":\"my \\\"tag\\\"\""), std::string::npos);
+  EXPECT_NE(json.find("\"cat\":\"spawn\""), std::string::npos);
+  EXPECT_NE(json.find("\"cat\":\"block\""), std::string::npos);
+  EXPECT_NE(json.find("\"cat\":\"exit\""), std::string::npos);
+  EXPECT_NE(json.find("\"ph\":\"s\""), std::string::npos);
+  EXPECT_NE(json.find("\"ph\":\"f\""), std::string::npos);
+}
+
+}  // namespace sched
+}  // namespace coro
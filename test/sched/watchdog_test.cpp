@@ -0,0 +1,81 @@
+#include "coro/sched/watchdog.hpp"
+
+#include <gtest/gtest.h>
+#include <signal.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+#include "coro/sched.hpp"
+#include "coro/spawn.hpp"
+
+namespace coro {
+namespace sched {
+
+static std::atomic<int> urgent_signals(0);
+
+static void onUrgentSignal(int signo) { urgent_signals++; }
+
+// 看门狗第一次启动时才安装信号处理函数，所以这个测试必须最先运行。
+TEST(WatchdogTest, ChainPreviousHandler) {
+  struct sigaction action = {};
+  action.sa_handler = onUrgentSignal;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGURG, &action, nullptr);
+
+  // 不是看门狗发出的信号应交给之前的处理函数。
+  startWatchdog(std::chrono::milliseconds(100), nullptr);
+  raise(SIGURG);
+  stopWatchdog();
+  EXPECT_EQ(urgent_signals.load(), 1);
+}
+
+TEST(WatchdogTest, Preempt) {
+  std::mutex mutex;
+  StallReport report{0, std::chrono::nanoseconds(0), {}};
+  startWatchdog(std::chrono::milliseconds(20),
+                [&mutex, &report](const StallReport& r) {
+                  std::lock_guard<std::mutex> lock(mutex);
+                  report = r;
+                });
+
+  bool done = false;
+  uint64_t busy_id = 0;
+  auto busy = spawn([&done, &busy_id]() {
+    busy_id = currentPtr()->id();
+    auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    // 不会主动让出 CPU 的循环，只能由看门狗抢占。
+    while (!done && std::chrono::steady_clock::now() < deadline) {
+      checkpoint();
+    }
+  });
+  auto other = spawn([&done]() { done = true; });
+  busy.await();
+  other.await();
+  stopWatchdog();
+
+  EXPECT_TRUE(done);
+  std::lock_guard<std::mutex> lock(mutex);
+  EXPECT_EQ(report.coro_id, busy_id);
+  EXPECT_GE(report.elapsed, std::chrono::milliseconds(20));
+  EXPECT_FALSE(report.backtrace.empty());
+}
+
+TEST(WatchdogTest, IdleIsNotStall) {
+  std::atomic<int> stalls(0);
+  startWatchdog(std::chrono::milliseconds(10),
+                [&stalls](const StallReport& r) { stalls++; });
+  auto promise = spawn([]() {
+    for (int i = 0; i < 10; i++) {
+      yield();
+    }
+  });
+  promise.await();
+  stopWatchdog();
+  EXPECT_EQ(stalls.load(), 0);
+}
+
+}  // namespace sched
+}  // namespace coro
@@ -0,0 +1,157 @@
+#include "coro/stream.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "coro/pipe.hpp"
+#include "coro/spawn.hpp"
+
+namespace coro {
+
+TEST(StreamTest, PeekConsume) {
+  auto ends = pipe();
+  EXPECT_TRUE(ends.second->peek().empty());
+
+  ends.first->write("hello world", 11).await();
+  ASSERT_EQ(ends.second->fill().await(), 11);
+  EXPECT_EQ(ends.second->peek(), "hello world");
+
+  ends.second->consume(6);
+  EXPECT_EQ(ends.second->peek(), "world");
+
+  // read 先从读缓冲区中读取。
+  char buf[16];
+  ASSERT_EQ(ends.second->read(buf, sizeof(buf)).await(), 5);
+  EXPECT_EQ(std::string(buf, 5), "world");
+  EXPECT_TRUE(ends.second->peek().empty());
+}
+
+TEST(StreamTest, FillAppends) {
+  auto ends = pipe();
+  ends.first->write("abc", 3).await();
+  ends.second->fill().await();
+  ends.first->write("def", 3).await();
+  ends.second->fill().await();
+  EXPECT_EQ(ends.second->peek(), "abcdef");
+
+  // 读缓冲区已满时扩容，已有的数据保持不变。
+  std::string data(2 * kDefaultReadBufferSize, 'x');
+  ends.first->write(data.data(), data.size()).await();
+  while (ends.second->peek().size() < 6 + data.size()) {
+    ASSERT_GT(ends.second->fill().await(), 0);
+  }
+  EXPECT_EQ(ends.second->peek().substr(0, 6), "abcdef");
+}
+
+TEST(StreamTest, Readline) {
+  auto ends = pipe();
+  ends.first->write("first\nsecond\nrest", 17).await();
+  ends.first->close();
+
+  char buf[16];
+  ASSERT_EQ(ends.second->readline(buf, sizeof(buf)).await(), 6);
+  EXPECT_EQ(std::string(buf, 6), "first\n");
+  // 剩余的数据留在读缓冲区中。
+  EXPECT_EQ(ends.second->peek(), "second\nrest");
+  ASSERT_EQ(ends.second->readline(buf, sizeof(buf)).await(), 7);
+  EXPECT_EQ(std::string(buf, 7), "second\n");
+  // 读到 EOF 时返回剩余的数据。
+  ASSERT_EQ(ends.second->readline(buf, sizeof(buf)).await(), 4);
+  EXPECT_EQ(std::string(buf, 4), "rest");
+  EXPECT_EQ(ends.second->readline(buf, sizeof(buf)).await(), 0);
+}
+
+TEST(StreamTest, Writev) {
+  // 默认实现逐个写入缓冲区。
+  auto ends = pipe();
+  boost::asio::const_buffer bufs[] = {boost::asio::buffer("ab", 2),
+                                      boost::asio::buffer("", 0),
+                                      boost::asio::buffer("cde", 3)};
+  EXPECT_EQ(ends.first->writev(bufs, 3).await(), 5);
+  ends.second->fill().await();
+  EXPECT_EQ(ends.second->peek(), "abcde");
+}
+
+TEST(StreamTest, Readv) {
+  auto ends = pipe();
+  ends.first->write("hello world", 11).await();
+  ends.second->fill().await();
+
+  // 读缓冲区非空时依次拷贝到各个缓冲区。
+  char first[5];
+  char second[16];
+  boost::asio::mutable_buffer bufs[] = {boost::asio::buffer(first),
+                                        boost::asio::buffer(second)};
+  ASSERT_EQ(ends.second->readv(bufs, 2).await(), 11);
+  EXPECT_EQ(std::string(first, 5), "hello");
+  EXPECT_EQ(std::string(second, 6), " world");
+}
+
+TEST(StreamTest, ReadUntil) {
+  auto ends = pipe();
+  // 一行数据分多次到达。
+  auto reader = spawn([&ends]() {
+    return ends.second->readUntil('\n', 64).await().to_string();
+  });
+  ends.first->write("GET / HT", 8).await();
+  ends.first->write("TP/1.1\r", 7).await();
+  ends.first->write("\nHost", 5).await();
+  EXPECT_EQ(reader.await(), "GET / HTTP/1.1\r\n");
+  EXPECT_EQ(ends.second->peek(), "Host");
+
+  // 超过 max 时返回 max 个字节。
+  EXPECT_EQ(ends.second->readUntil('\n', 2).await(), "Ho");
+
+  // 读到 EOF 时返回剩余的数据。
+  ends.first->close();
+  EXPECT_EQ(ends.second->readUntil('\n', 64).await(), "st");
+  EXPECT_TRUE(ends.second->readUntil('\n', 64).await().empty());
+}
+
+TEST(StreamTest, ReadlineSplit) {
+  // 一行数据分多次到达时，先到达的数据不会被覆盖。
+  auto ends = pipe();
+  auto reader = spawn([&ends]() {
+    char buf[64];
+    size_t n = ends.second->readline(buf, sizeof(buf)).await();
+    return std::string(buf, n);
+  });
+  ends.first->write("*2\r", 3).await();
+  ends.first->write("\n$3\r\n", 6).await();
+  EXPECT_EQ(reader.await(), "*2\r\n");
+}
+
+TEST(StreamTest, ReadlineManySyncReads) {
+  // 容量为 1 的管道每次只能读到一个字节，且读取都是同步完成的，
+  // 读取的次数不应加深协程的调用栈。
+  auto ends = pipe(1);
+  std::string line(256 * 1024, 'x');
+  line += '\n';
+  auto reader = spawn([&ends, &line]() {
+    std::string buf(line.size(), '\0');
+    size_t n = ends.second->readline(&buf[0], buf.size()).await();
+    buf.resize(n);
+    auto view = ends.second->readUntil('\n', line.size()).await();
+    return buf == line && view == line;
+  });
+  ends.first->write(line.data(), line.size()).await();
+  ends.first->write(line.data(), line.size()).await();
+  EXPECT_TRUE(reader.await());
+}
+
+TEST(StreamTest, PooledReadBuffer) {
+  auto ends = pipe();
+  ends.second->setPooledReadBuffer(true);
+  ends.first->write("first\nsecond\n", 13).await();
+  ends.first->close();
+
+  // 读缓冲区中还有数据时不归还，视图保持有效。
+  auto first = ends.second->readUntil('\n', 64).await();
+  EXPECT_EQ(ends.second->peek(), "second\n");
+  EXPECT_EQ(first, "first\n");
+  EXPECT_EQ(ends.second->readUntil('\n', 64).await(), "second\n");
+  EXPECT_EQ(ends.second->readUntil('\n', 64).await(), "");
+}
+
+}  // namespace coro
@@ -0,0 +1,358 @@
+#include "coro/tcp/conn.hpp"
+
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+
+#include "coro/buffer_pool.hpp"
+#include "coro/http.hpp"
+#include "coro/sched/sched.hpp"
+#include "coro/sleep.hpp"
+#include "coro/spawn.hpp"
+#include "coro/tcp.hpp"
+
+namespace coro {
+namespace tcp {
+
+static int getIntOption(const Conn& conn, int level, int name) {
+  int value = 0;
+  socklen_t len = sizeof(value);
+  EXPECT_EQ(getsockopt(conn->nativeHandle(), level, name, &value, &len), 0);
+  return value;
+}
+
+TEST(ConnTest, WritevReadv) {
+  auto listener = listen(0);
+  auto server = spawn([listener]() {
+    auto conn = listener->accept().await();
+    char head[4];
+    char body[16];
+    boost::asio::mutable_buffer bufs[] = {
+        boost::asio::buffer(head), boost::asio::buffer(body)};
+    size_t total = 0;
+    while (total < 11) {
+      size_t n = conn->readv(bufs, 2).await();
+      EXPECT_GT(n, 0);
+      total += n;
+      // 继续读取时跳过已经填充的部分。
+      bufs[0] = boost::asio::buffer(head) + std::min<size_t>(total, 4);
+      bufs[1] = boost::asio::buffer(body) + (total > 4 ? total - 4 : 0);
+    }
+    return std::string(head, 4) + "|" + std::string(body, total - 4);
+  });
+
+  auto conn = connect("127.0.0.1", listener->port()).await();
+  boost::asio::const_buffer bufs[] = {boost::asio::buffer("GET ", 4),
+                                      boost::asio::buffer("", 0),
+                                      boost::asio::buffer("/index", 6),
+                                      boost::asio::buffer("\n", 1)};
+  EXPECT_EQ(conn->writev(bufs, 4).await(), 11);
+  EXPECT_EQ(server.await(), "GET |/index\n");
+}
+
+TEST(ConnTest, WriteRespWithBody) {
+  auto listener = listen(0);
+  auto server = spawn([listener]() {
+    Stream conn = listener->accept().await();
+    http::protocol::Response resp;
+    resp.version = "HTTP/1.1";
+    resp.code = 200;
+    resp.reason = "OK";
+    resp.headers = {{"Content-Length", "5"}};
+    http::protocol::writeResp(conn, resp, "hello").await();
+  });
+
+  Stream conn = connect("127.0.0.1", listener->port()).await();
+  auto resp = http::protocol::readResp(conn).await();
+  EXPECT_EQ(resp.code, 200);
+  char body[5];
+  ASSERT_EQ(conn->readn(body, sizeof(body)).await(), 5);
+  EXPECT_EQ(std::string(body, 5), "hello");
+  server.await();
+}
+
+TEST(ConnTest, InlineRead) {
+  auto listener = listen(0);
+  auto server = spawn([listener]() { return listener->accept().await(); });
+  auto client = connect("127.0.0.1", listener->port()).await();
+  auto conn = server.await();
+
+  std::string data(kMaxInlineCompletions + 1, 'x');
+  client->write(data.data(), data.size()).await();
+  milliSleep(10).await();
+
+  // 数据已经在内核缓冲区中，读取同步完成，回调在注册时立即执行。
+  char chr;
+  for (size_t i = 0; i < kMaxInlineCompletions; i++) {
+    bool settled = false;
+    conn->read(&chr, 1).then([&settled](size_t n) { settled = true; });
+    EXPECT_TRUE(settled) << i;
+  }
+  // 连续同步完成的次数达到上限后，下一次读取走异步路径。
+  bool settled = false;
+  auto promise =
+      conn->read(&chr, 1).then([&settled](size_t n) { settled = true; });
+  EXPECT_FALSE(settled);
+  promise.await();
+  EXPECT_TRUE(settled);
+}
+
+TEST(ConnTest, InlineWritevReadv) {
+  auto listener = listen(0);
+  auto server = spawn([listener]() { return listener->accept().await(); });
+  auto client = connect("127.0.0.1", listener->port()).await();
+  auto conn = server.await();
+
+  // 发送缓冲区有空间，writev 同步完成，回调在注册时立即执行。
+  boost::asio::const_buffer out[] = {boost::asio::buffer("head", 4),
+                                     boost::asio::buffer("body", 4)};
+  bool settled = false;
+  client->writev(out, 2).then([&settled](size_t n) {
+    EXPECT_EQ(n, 8);
+    settled = true;
+  });
+  EXPECT_TRUE(settled);
+  milliSleep(10).await();
+
+  // 数据已经在内核缓冲区中，readv 同样同步完成。
+  char head[4];
+  char body[4];
+  boost::asio::mutable_buffer in[] = {boost::asio::buffer(head),
+                                      boost::asio::buffer(body)};
+  settled = false;
+  conn->readv(in, 2).then([&settled](size_t n) {
+    EXPECT_EQ(n, 8);
+    settled = true;
+  });
+  EXPECT_TRUE(settled);
+  EXPECT_EQ(std::string(head, 4) + std::string(body, 4), "headbody");
+}
+
+TEST(ConnTest, WritevPartial) {
+  auto listener = listen(0);
+  auto accept = spawn([listener]() { return listener->accept().await(); });
+  auto client = connect("127.0.0.1", listener->port()).await();
+  auto server = accept.await();
+
+  // 数据超过发送缓冲区，同步写入一部分后剩余的数据从中断处异步写入。
+  std::string first(4 * 1024 * 1024, 'a');
+  std::string second(4 * 1024 * 1024, 'b');
+  boost::asio::const_buffer bufs[] = {boost::asio::buffer(first),
+                                      boost::asio::buffer(second)};
+  auto writer = spawn([client, &bufs]() {
+    return client->writev(bufs, 2).await();
+  });
+  std::string received(first.size() + second.size(), '\0');
+  EXPECT_EQ(server->readn(&received[0], received.size()).await(),
+            received.size());
+  EXPECT_EQ(writer.await(), received.size());
+  EXPECT_TRUE(received == first + second);
+}
+
+TEST(ConnTest, ConcurrentWrites) {
+  auto listener = listen(0);
+  auto accept = spawn([listener]() { return listener->accept().await(); });
+  auto client = connect("127.0.0.1", listener->port()).await();
+  auto server = accept.await();
+
+  // a 的数据超过发送缓冲区，剩余部分异步写入；b 的写入不能插入其中。
+  std::string big(8 * 1024 * 1024, 'a');
+  auto a = spawn([client, &big]() {
+    return client->write(big.data(), big.size()).await();
+  });
+  auto b = spawn([client]() { return client->write("ZZZZ", 4).await(); });
+
+  std::string received(big.size() + 4, '\0');
+  EXPECT_EQ(server->readn(&received[0], received.size()).await(),
+            received.size());
+  EXPECT_EQ(a.await(), big.size());
+  EXPECT_EQ(b.await(), 4);
+  EXPECT_EQ(received.find('Z'), big.size());
+}
+
+TEST(ConnTest, PooledReadBuffer) {
+  auto listener = listen(0);
+  auto server = spawn([listener]() { return listener->accept().await(); });
+  auto client = connect("127.0.0.1", listener->port()).await();
+  auto conn = server.await();
+  conn->setPooledReadBuffer(true);
+  const BufferPoolStats& stats = sched::bufferPool().stats();
+
+  client->write("hello\n", 6).await();
+  EXPECT_EQ(conn->readUntil('\n', 64).await(), "hello\n");
+  size_t cached = stats.cached_buffers;
+
+  // 等待数据期间读缓冲区被归还给池。
+  auto reader = spawn(
+      [conn]() { return conn->readUntil('\n', 64).await().to_string(); });
+  milliSleep(10).await();
+  EXPECT_EQ(stats.cached_buffers, cached + 1);
+
+  // 数据到达后再从池中取出。
+  client->write("world\n", 6).await();
+  EXPECT_EQ(reader.await(), "world\n");
+  EXPECT_EQ(stats.cached_buffers, cached);
+}
+
+TEST(ConnTest, SendFile) {
+  char path[] = "/tmp/coro_conn_test_XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_GE(fd, 0);
+  unlink(path);
+  // 大于发送缓冲区，需要等待套接字可写后继续发送。
+  std::string data;
+  for (size_t i = 0; data.size() < 4 * 1024 * 1024; i++) {
+    data += std::to_string(i) + ",";
+  }
+  ASSERT_EQ(::write(fd, data.data(), data.size()), data.size());
+
+  auto listener = listen(0);
+  auto server = spawn([listener, fd, &data]() {
+    auto conn = listener->accept().await();
+    size_t n = conn->sendFile(fd, 100, data.size() - 100).await();
+    conn->close();
+    return n;
+  });
+
+  auto conn = connect("127.0.0.1", listener->port()).await();
+  std::string received(data.size() - 100, '\0');
+  EXPECT_EQ(conn->readn(&received[0], received.size()).await(),
+            received.size());
+  EXPECT_EQ(server.await(), received.size());
+  EXPECT_TRUE(received == data.substr(100));
+  // 文件偏移量不受影响。
+  EXPECT_EQ(lseek(fd, 0, SEEK_CUR), data.size());
+  close(fd);
+}
+
+/**
+ * @brief 关闭 peer 并等待 conn 的写入失败，此后 conn 的对端已被重置。
+ */
+static void resetPeer(const Conn& conn, const Conn& peer) {
+  peer->close();
+  std::error_code error;
+  while (!error) {
+    conn->write("x", 1).await(&error);
+    milliSleep(1).await();
+  }
+}
+
+TEST(ConnTest, SendFileAfterPeerClosed) {
+  char path[] = "/tmp/coro_conn_test_XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_GE(fd, 0);
+  unlink(path);
+  std::string data(64 * 1024, 'x');
+  ASSERT_EQ(::write(fd, data.data(), data.size()), data.size());
+
+  auto listener = listen(0);
+  auto accept = spawn([listener]() { return listener->accept().await(); });
+  auto client = connect("127.0.0.1", listener->port()).await();
+  auto server = accept.await();
+  resetPeer(server, client);
+
+  // 写入已重置的连接产生 SIGPIPE，sendfile 不能因此终止进程。
+  std::error_code error;
+  server->sendFile(fd, 0, data.size()).await(&error);
+  EXPECT_TRUE(error);
+  close(fd);
+}
+
+TEST(ConnTest, Splice) {
+  auto listener = listen(0);
+  auto accept = spawn([listener]() { return listener->accept().await(); });
+  auto client = connect("127.0.0.1", listener->port()).await();
+  auto src = accept.await();
+  accept = spawn([listener]() { return listener->accept().await(); });
+  auto peer = connect("127.0.0.1", listener->port()).await();
+  auto dst = accept.await();
+
+  // 读缓冲区中已有的数据先被转发。
+  client->write("head\n", 5).await();
+  EXPECT_EQ(src->readUntil('\n', 2).await(), "he");
+
+  std::string data(1024 * 1024, 'x');
+  auto writer = spawn([client, &data]() {
+    client->write(data.data(), data.size()).await();
+    client->close();
+  });
+  auto forwarder = spawn([src, dst]() {
+    size_t total = 0;
+    for (;;) {
+      size_t n = dst->splice(src, 16 * 1024).await();
+      if (n == 0) {
+        break;
+      }
+      total += n;
+    }
+    dst->close();
+    return total;
+  });
+
+  std::string received(3 + data.size(), '\0');
+  EXPECT_EQ(peer->readn(&received[0], received.size()).await(),
+            received.size());
+  writer.await();
+  EXPECT_EQ(forwarder.await(), received.size());
+  EXPECT_TRUE(received == "ad\n" + data);
+}
+
+TEST(ConnTest, SocketOptions) {
+  auto listener = listen(0);
+  auto accept = spawn([listener]() { return listener->accept().await(); });
+  SocketOptions options;
+  options.no_delay = true;
+  options.not_sent_lowat = 16 * 1024;
+  options.keepalive_idle = 30;
+  options.keepalive_count = 3;
+  auto client = connect("127.0.0.1", listener->port(), options).await();
+  auto server = accept.await();
+
+  EXPECT_EQ(getIntOption(client, IPPROTO_TCP, TCP_NODELAY), 1);
+  EXPECT_EQ(getIntOption(client, IPPROTO_TCP, TCP_NOTSENT_LOWAT), 16 * 1024);
+  EXPECT_EQ(getIntOption(client, SOL_SOCKET, SO_KEEPALIVE), 1);
+  EXPECT_EQ(getIntOption(client, IPPROTO_TCP, TCP_KEEPIDLE), 30);
+  EXPECT_EQ(getIntOption(client, IPPROTO_TCP, TCP_KEEPCNT), 3);
+  // 未指定的选项保持系统默认值。
+  EXPECT_EQ(getIntOption(server, IPPROTO_TCP, TCP_NODELAY), 0);
+
+  // 建立连接之后修改选项，fast_open 被忽略。
+  SocketOptions update;
+  update.no_delay = true;
+  update.fast_open = true;
+  EXPECT_FALSE(server->setOptions(update));
+  EXPECT_EQ(getIntOption(server, IPPROTO_TCP, TCP_NODELAY), 1);
+
+  client->write("x", 1).await();
+  char chr;
+  EXPECT_EQ(server->read(&chr, 1).await(), 1);
+}
+
+TEST(ConnTest, SpliceAfterPeerClosed) {
+  auto listener = listen(0);
+  auto accept = spawn([listener]() { return listener->accept().await(); });
+  auto client = connect("127.0.0.1", listener->port()).await();
+  auto src = accept.await();
+  accept = spawn([listener]() { return listener->accept().await(); });
+  auto peer = connect("127.0.0.1", listener->port()).await();
+  auto dst = accept.await();
+  resetPeer(dst, peer);
+
+  // 转发到已重置的连接产生 SIGPIPE，splice 不能因此终止进程。
+  std::string data(64 * 1024, 'x');
+  client->write(data.data(), data.size()).await();
+  std::error_code error;
+  for (int i = 0; i < 16 && !error; i++) {
+    dst->splice(src, data.size()).await(&error);
+  }
+  EXPECT_TRUE(error);
+}
+
+}  // namespace tcp
+}  // namespace coro
@@ -0,0 +1,405 @@
+#include "coro/tcp/listener.hpp"
+
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <fcntl.h>
+#include <netinet/tcp.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "coro/sched/sched.hpp"
+#include "coro/sleep.hpp"
+#include "coro/spawn.hpp"
+#include "coro/tcp.hpp"
+
+namespace coro {
+namespace tcp {
+
+/**
+ * @brief 占用 CPU 一段时间，期间不让出。
+ */
+static void spin(std::chrono::milliseconds duration) {
+  auto deadline = std::chrono::steady_clock::now() + duration;
+  while (std::chrono::steady_clock::now() < deadline) {
+  }
+}
+
+TEST(ListenerTest, AddressInUse) {
+  auto first = listen(0);
+  std::error_code error;
+  auto second = listen("127.0.0.1", first->port(), &error);
+  EXPECT_EQ(second, nullptr);
+  EXPECT_EQ(error, std::errc::address_in_use);
+}
+
+TEST(ListenerTest, ReusePort) {
+  ListenOptions options;
+  options.reuse_port = true;
+  auto first = listen("127.0.0.1", 0, options);
+  auto second = listen("127.0.0.1", first->port(), options);
+  ASSERT_NE(second, nullptr);
+
+  // 内核将连接分配给两个监听套接字之一。
+  size_t accepted = 0;
+  std::vector<Promise<void>> acceptors;
+  for (const Listener& listener : {first, second}) {
+    acceptors.push_back(spawn([listener, &accepted]() {
+      std::vector<Conn> conns;
+      for (;;) {
+        std::error_code error;
+        auto conn = listener->accept().await(&error);
+        if (error) {
+          break;
+        }
+        conns.push_back(conn);
+        accepted++;
+      }
+    }));
+  }
+
+  constexpr size_t kClients = 8;
+  std::vector<Conn> clients;
+  for (size_t i = 0; i < kClients; i++) {
+    clients.push_back(connect("127.0.0.1", first->port()).await());
+  }
+  while (accepted < kClients) {
+    milliSleep(1).await();
+  }
+  first->close();
+  second->close();
+  for (auto& acceptor : acceptors) {
+    acceptor.await();
+  }
+  EXPECT_EQ(accepted, kClients);
+}
+
+TEST(ListenerTest, CpuSteering) {
+  // 组的大小超过 CPU 个数也没有关系，没有对应 CPU 的监听套接字收不到连接；
+  // 不附加程序时内核按四元组的哈希分配，连接几乎不可能全部落在预期的套接字上。
+  constexpr size_t kGroup = 4;
+  ListenOptions options;
+  options.reuse_port = true;
+  options.cpu_steering_group = kGroup;
+  std::vector<Listener> listeners;
+  listeners.push_back(listen("127.0.0.1", 0, options));
+  for (size_t i = 1; i < kGroup; i++) {
+    listeners.push_back(listen("127.0.0.1", listeners[0]->port(), options));
+    ASSERT_NE(listeners.back(), nullptr);
+  }
+
+  std::vector<size_t> accepted(kGroup);
+  std::vector<Conn> conns;
+  std::vector<Promise<void>> acceptors;
+  for (size_t i = 0; i < kGroup; i++) {
+    acceptors.push_back(spawn([&listeners, &accepted, &conns, i]() {
+      for (;;) {
+        std::error_code error;
+        auto conn = listeners[i]->accept().await(&error);
+        if (error) {
+          break;
+        }
+        conns.push_back(conn);
+        accepted[i]++;
+      }
+    }));
+  }
+
+  // 回环网卡上 SYN 在发送方的 CPU 上处理，将客户端线程固定在各个 CPU 上连接，
+  // 连接应当由下标为 CPU 编号 % kGroup 的监听套接字接受。
+  cpu_set_t original;
+  ASSERT_EQ(sched_getaffinity(0, sizeof(original), &original), 0);
+  constexpr size_t kClientsPerCpu = 8;
+  std::vector<Conn> clients;
+  for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+    if (!CPU_ISSET(cpu, &original)) {
+      continue;
+    }
+    cpu_set_t pinned;
+    CPU_ZERO(&pinned);
+    CPU_SET(cpu, &pinned);
+    ASSERT_EQ(sched_setaffinity(0, sizeof(pinned), &pinned), 0);
+    std::vector<size_t> expected = accepted;
+    expected[cpu % kGroup] += kClientsPerCpu;
+    for (size_t i = 0; i < kClientsPerCpu; i++) {
+      clients.push_back(connect("127.0.0.1", listeners[0]->port()).await());
+    }
+    while (clients.size() > conns.size()) {
+      milliSleep(1).await();
+    }
+    EXPECT_EQ(accepted, expected) << "cpu " << cpu;
+  }
+  ASSERT_EQ(sched_setaffinity(0, sizeof(original), &original), 0);
+
+  for (const Listener& listener : listeners) {
+    listener->close();
+  }
+  for (auto& acceptor : acceptors) {
+    acceptor.await();
+  }
+}
+
+TEST(ListenerTest, AcceptBatch) {
+  auto listener = listen(0);
+  std::vector<Conn> clients;
+  for (int i = 0; i < 5; i++) {
+    clients.push_back(connect("127.0.0.1", listener->port()).await());
+  }
+
+  // 监听队列中已有 5 个连接，分两批接受。
+  EXPECT_EQ(listener->acceptBatch(3).await().size(), 3);
+  auto conns = listener->acceptBatch(10).await();
+  ASSERT_EQ(conns.size(), 2);
+
+  // 队列为空时等待新连接。
+  auto batch =
+      spawn([listener]() { return listener->acceptBatch(10).await(); });
+  clients.push_back(connect("127.0.0.1", listener->port()).await());
+  conns = batch.await();
+  ASSERT_EQ(conns.size(), 1);
+  clients.back()->write("x", 1).await();
+  char chr;
+  EXPECT_EQ(conns[0]->read(&chr, 1).await(), 1);
+}
+
+TEST(ListenerTest, AcceptBatchZero) {
+  // max 为 0 时立即返回，连接留在监听队列中。
+  auto listener = listen(0);
+  auto client = connect("127.0.0.1", listener->port()).await();
+  EXPECT_TRUE(listener->acceptBatch(0).await().empty());
+  EXPECT_EQ(listener->acceptBatch(10).await().size(), 1);
+}
+
+TEST(ListenerTest, Serve) {
+  auto listener = listen(0);
+  auto served = listener->serve([](Conn conn) {
+    char buf[16];
+    size_t n = conn->readline(buf, sizeof(buf)).await();
+    conn->write(buf, n).await();
+  });
+
+  std::vector<Promise<std::string>> clients;
+  for (int i = 0; i < 4; i++) {
+    clients.push_back(spawn([listener, i]() {
+      auto conn = connect("127.0.0.1", listener->port()).await();
+      std::string line = std::to_string(i) + "\n";
+      conn->write(line.data(), line.size()).await();
+      char buf[16];
+      size_t n = conn->readline(buf, sizeof(buf)).await();
+      return std::string(buf, n);
+    }));
+  }
+  for (int i = 0; i < 4; i++) {
+    EXPECT_EQ(clients[i].await(), std::to_string(i) + "\n");
+  }
+
+  // 关闭监听器后 serve 正常结束。
+  listener->close();
+  served.await();
+}
+
+TEST(ListenerTest, ServeRetriesOnEmfile) {
+  auto listener = listen(0);
+  size_t accepted = 0;
+  auto served = listener->serve([&accepted](Conn conn) { accepted++; });
+
+  // 降低文件描述符上限，使新连接只能停留在监听队列中，accept 返回 EMFILE。
+  int client = ::socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_GE(client, 0);
+  int lowest = ::open("/dev/null", O_RDONLY);
+  ASSERT_GE(lowest, 0);
+  ::close(lowest);
+  struct rlimit old_limit;
+  ASSERT_EQ(getrlimit(RLIMIT_NOFILE, &old_limit), 0);
+  struct rlimit limit = old_limit;
+  limit.rlim_cur = lowest;
+  ASSERT_EQ(setrlimit(RLIMIT_NOFILE, &limit), 0);
+
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(listener->port());
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  int ret = ::connect(client, reinterpret_cast<struct sockaddr*>(&addr),
+                      sizeof(addr));
+  milliSleep(20).await();
+  setrlimit(RLIMIT_NOFILE, &old_limit);
+  ASSERT_EQ(ret, 0);
+  EXPECT_EQ(accepted, 0);
+
+  // 资源恢复后 serve 继续接受连接，而不是因 EMFILE 结束。
+  for (int i = 0; i < 2000 && accepted == 0; i++) {
+    milliSleep(1).await();
+  }
+  EXPECT_EQ(accepted, 1);
+  ::close(client);
+  listener->close();
+  served.await();
+}
+
+TEST(ListenerTest, SocketOptions) {
+  ListenOptions options;
+  options.socket.no_delay = true;
+  options.socket.quick_ack = true;
+  options.socket.fast_open = true;
+  options.socket.keepalive_idle = 60;
+  options.socket.keepalive_interval = 5;
+  auto listener = listen("127.0.0.1", 0, options);
+
+  auto option = [](const Conn& conn, int level, int name) {
+    int value = 0;
+    socklen_t len = sizeof(value);
+    EXPECT_EQ(getsockopt(conn->nativeHandle(), level, name, &value, &len), 0);
+    return value;
+  };
+  // accept 和 acceptBatch 接受的连接都继承监听套接字的选项。
+  std::vector<Conn> clients;
+  clients.push_back(connect("127.0.0.1", listener->port()).await());
+  clients.push_back(connect("127.0.0.1", listener->port()).await());
+  std::vector<Conn> conns;
+  conns.push_back(listener->accept().await());
+  conns.push_back(listener->acceptBatch(1).await()[0]);
+  for (const Conn& conn : conns) {
+    EXPECT_EQ(option(conn, IPPROTO_TCP, TCP_NODELAY), 1);
+    EXPECT_EQ(option(conn, SOL_SOCKET, SO_KEEPALIVE), 1);
+    EXPECT_EQ(option(conn, IPPROTO_TCP, TCP_KEEPIDLE), 60);
+    EXPECT_EQ(option(conn, IPPROTO_TCP, TCP_KEEPINTVL), 5);
+  }
+  EXPECT_EQ(option(clients[0], IPPROTO_TCP, TCP_NODELAY), 0);
+}
+
+TEST(ListenerTest, MaxConns) {
+  auto listener = listen(0);
+  ServeOptions options;
+  options.max_conns = 2;
+  size_t handled = 0;
+  auto served = listener->serve(
+      [&handled](Conn conn) {
+        handled++;
+        // 客户端关闭连接时返回。
+        char chr;
+        std::error_code error;
+        conn->read(&chr, 1).await(&error);
+      },
+      options);
+
+  std::vector<Conn> clients;
+  for (int i = 0; i < 3; i++) {
+    clients.push_back(connect("127.0.0.1", listener->port()).await());
+  }
+  milliSleep(10).await();
+  EXPECT_EQ(handled, 2);
+  EXPECT_EQ(listener->activeConns(), 2);
+
+  // 一个 handler 返回后接受第三个连接。
+  clients[0]->close();
+  while (handled < 3) {
+    milliSleep(1).await();
+  }
+  EXPECT_EQ(listener->activeConns(), 2);
+
+  // 连接数达到上限时关闭监听器，serve 同样结束。
+  listener->close();
+  served.await();
+  for (auto& client : clients) {
+    client->close();
+  }
+  while (listener->activeConns() > 0) {
+    milliSleep(1).await();
+  }
+}
+
+TEST(ListenerTest, Shed) {
+  using std::chrono::milliseconds;
+  auto listener = listen(0);
+  ServeOptions options;
+  options.shed_target = milliseconds(2);
+  options.shed_interval = milliseconds(20);
+  options.shed_handler = [](Conn conn) {
+    conn->write("busy\n", 5).await();
+    conn->close();
+  };
+  size_t handled = 0;
+  auto served = listener->serve([&handled](Conn) { handled++; }, options);
+
+  // 持续占用 CPU，使调度延迟在整个窗口内超过目标。
+  bool loaded = true;
+  auto load = spawn([&loaded]() {
+    while (loaded) {
+      spin(milliseconds(10));
+      milliSleep(0).await();
+    }
+  });
+  milliSleep(100).await();
+  auto conn = connect("127.0.0.1", listener->port()).await();
+  char buf[5];
+  EXPECT_EQ(conn->readn(buf, sizeof(buf)).await(), sizeof(buf));
+  EXPECT_EQ(std::string(buf, sizeof(buf)), "busy\n");
+  EXPECT_EQ(listener->shedConns(), 1);
+  EXPECT_EQ(handled, 0);
+
+  // 负载消失后恢复接受连接。
+  loaded = false;
+  load.await();
+  while (sched::queueDelay() > options.shed_target) {
+    milliSleep(5).await();
+  }
+  conn = connect("127.0.0.1", listener->port()).await();
+  while (handled < 1) {
+    milliSleep(1).await();
+  }
+  EXPECT_EQ(listener->shedConns(), 1);
+  listener->close();
+  served.await();
+  // serve 结束后停止测量调度延迟。
+  EXPECT_EQ(sched::queueDelay().count(), 0);
+}
+
+TEST(ListenerTest, MaxShedHandlers) {
+  using std::chrono::milliseconds;
+  auto listener = listen(0);
+  ServeOptions options;
+  options.shed_target = milliseconds(2);
+  options.shed_interval = milliseconds(20);
+  options.max_shed_handlers = 1;
+  Promise<void> gate;
+  options.shed_handler = [gate](Conn conn) {
+    gate.await();
+    conn->write("busy\n", 5).await();
+  };
+  auto served = listener->serve([](Conn) {}, options);
+
+  bool loaded = true;
+  auto load = spawn([&loaded]() {
+    while (loaded) {
+      spin(milliseconds(10));
+      milliSleep(0).await();
+    }
+  });
+  milliSleep(100).await();
+  // 第一个连接交给 shed_handler，它尚未返回时第二个连接被直接关闭。
+  auto first = connect("127.0.0.1", listener->port()).await();
+  while (listener->shedConns() < 1) {
+    milliSleep(1).await();
+  }
+  auto second = connect("127.0.0.1", listener->port()).await();
+  char buf[5];
+  std::error_code error;
+  EXPECT_EQ(second->read(buf, sizeof(buf)).await(&error), 0);
+  EXPECT_TRUE(error);
+  EXPECT_EQ(listener->shedConns(), 2);
+
+  gate.resolve();
+  EXPECT_EQ(first->readn(buf, sizeof(buf)).await(), sizeof(buf));
+  loaded = false;
+  load.await();
+  listener->close();
+  served.await();
+}
+
+}  // namespace tcp
+}  // namespace coro
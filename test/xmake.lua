@@ -22,6 +22,14 @@ target("test_sched_stack")
     add_deps("coro")
     add_packages("boost", "gtest")
 
+target("test_sched_arena")
+    set_kind("binary")
+    set_group("test")
+    add_files("sched/arena_test.cpp")
+    add_includedirs("$(projectdir)/include")
+    add_deps("coro")
+    add_packages("boost", "gtest")
+
 target("test_sched_sched")
     set_kind("binary")
     set_group("test")
@@ -30,6 +38,30 @@ target("test_sched_sched")
     add_deps("coro")
     add_packages("boost", "gtest")
 
+target("test_sched_stats")
+    set_kind("binary")
+    set_group("test")
+    add_files("sched/stats_test.cpp")
+    add_includedirs("$(projectdir)/include")
+    add_deps("coro")
+    add_packages("boost", "gtest")
+
+target("test_sched_trace")
+    set_kind("binary")
+    set_group("test")
+    add_files("sched/trace_test.cpp")
+    add_includedirs("$(projectdir)/include")
+    add_deps("coro")
+    add_packages("boost", "gtest")
+
+target("test_sched_watchdog")
+    set_kind("binary")
+    set_group("test")
+    add_files("sched/watchdog_test.cpp")
+    add_includedirs("$(projectdir)/include")
+    add_deps("coro")
+    add_packages("boost", "gtest")
+
 target("test_sched_promise")
     set_kind("binary")
     set_group("test")
@@ -37,3 +69,91 @@ target("test_sched_promise")
     add_includedirs("$(projectdir)/include")
     add_deps("coro")
     add_packages("boost", "gtest")
+
+target("test_local")
+    set_kind("binary")
+    set_group("test")
+    add_files("local_test.cpp")
+    add_includedirs("$(projectdir)/include")
+    add_deps("coro")
+    add_packages("boost", "gtest")
+
+target("test_sched_registry")
+    set_kind("binary")
+    set_group("test")
+    add_files("sched/registry_test.cpp")
+    add_includedirs("$(projectdir)/include")
+    add_deps("coro")
+    add_packages("boost", "gtest")
+
+target("test_alloc")
+    set_kind("binary")
+    set_group("test")
+    add_files("alloc_test.cpp", "alloc_hook.cpp")
+    add_includedirs("$(projectdir)/include")
+    add_deps("coro")
+    add_packages("boost", "gtest")
+
+target("test_pipe")
+    set_kind("binary")
+    set_group("test")
+    add_files("pipe_test.cpp")
+    add_includedirs("$(projectdir)/include")
+    add_deps("coro")
+    add_packages("boost", "gtest")
+
+target("test_stream")
+    set_kind("binary")
+    set_group("test")
+    add_files("stream_test.cpp")
+    add_includedirs("$(projectdir)/include")
+    add_deps("coro")
+    add_packages("boost", "gtest")
+
+target("test_scan")
+    set_kind("binary")
+    set_group("test")
+    add_files("scan_test.cpp")
+    add_includedirs("$(projectdir)/include")
+    add_deps("coro")
+    add_packages("boost", "gtest")
+
+target("test_tcp_conn")
+    set_kind("binary")
+    set_group("test")
+    add_files("tcp/conn_test.cpp")
+    add_includedirs("$(projectdir)/include")
+    add_deps("coro")
+    add_packages("boost", "gtest")
+
+target("test_buffered_writer")
+    set_kind("binary")
+    set_group("test")
+    add_files("buffered_writer_test.cpp")
+    add_includedirs("$(projectdir)/include")
+    add_deps("coro")
+    add_packages("boost", "gtest")
+
+target("test_buffer_pool")
+    set_kind("binary")
+    set_group("test")
+    add_files("buffer_pool_test.cpp")
+    add_includedirs("$(projectdir)/include")
+    add_deps("coro")
+    add_packages("boost", "gtest")
+
+target("test_pump")
+    set_kind("binary")
+    set_group("test")
+    add_files("pump_test.cpp")
+    add_includedirs("$(projectdir)/include")
+    add_deps("coro")
+    add_packages("boost", "gtest")
+
+target("test_tcp_listener")
+    set_kind("binary")
+    set_group("test")
+    add_files("tcp/listener_test.cpp")
+    add_includedirs("$(projectdir)/include")
+    add_deps("coro")
+    add_packages("boost", "gtest")
@@ -6,12 +6,24 @@ set_languages("c++11")
 add_rules("mode.debug", "mode.release")
 add_requires("boost >= 1.80", {configs = {context = true}})
 add_requires("gtest >= 1.12")
+add_requires("benchmark")
+
+-- USDT 追踪点，需要 <sys/sdt.h>（systemtap-sdt-dev），找不到时追踪点为空。
+option("usdt")
+    set_default(true)
+    set_showmenu(true)
+    set_description("Enable USDT probes for perf and bpftrace")
+    add_defines("CORO_USDT")
+option_end()
 
 target("coro")
     set_kind("static")
     add_files("src/**.cpp")
     add_includedirs("include")
     add_packages("boost")
+    add_options("usdt")
+    add_syslinks("pthread", {public = true})
 
+includes("bench")
 includes("examples")
 includes("test")